@@ -0,0 +1,12 @@
+#ifndef __GTEMAC_SHIM_H
+#define __GTEMAC_SHIM_H
+
+#include "psxshim.h"
+
+#define gte_SetRotMatrix(m) SetRotMatrix(m)
+#define gte_SetTransMatrix(m) SetTransMatrix(m)
+#define gte_CompMatrix(r1, r2, r3) CompMatrixLV(r1, r2, r3)
+#define gte_SetGeomOffset(ofx, ofy) SetGeomOffset(ofx, ofy)
+#define gte_SetGeomScreen(h) SetGeomScreen(h)
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __INLINE_N_SHIM_H
+#define __INLINE_N_SHIM_H
+
+#include "psxshim.h"
+
+// Register-level GTE operations, emulated on a software copy of the GTE state
+void ShimGteLdv0(SVECTOR* v);
+void ShimGteLdv3(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2);
+void ShimGteRtps(void);
+void ShimGteRtpt(void);
+void ShimGteNclip(void);
+void ShimGteAvsz3(void);
+void ShimGteAvsz4(void);
+void ShimGteStsxy(long* sxy);
+void ShimGteStsxy3(long* sxy0, long* sxy1, long* sxy2);
+void ShimGteStsz(long* sz);
+void ShimGteStsz3(long* sz0, long* sz1, long* sz2);
+void ShimGteStopz(long* opz);
+void ShimGteStotz(long* otz);
+void ShimGteStflg(long* flg);
+void ShimGteLdsxy3(long sxy0, long sxy1, long sxy2);
+
+#define gte_ldv0(r0) ShimGteLdv0((SVECTOR*)(r0))
+#define gte_ldv3(r0, r1, r2) ShimGteLdv3((SVECTOR*)(r0), (SVECTOR*)(r1), (SVECTOR*)(r2))
+#define gte_rtps() ShimGteRtps()
+#define gte_rtpt() ShimGteRtpt()
+#define gte_nclip() ShimGteNclip()
+#define gte_avsz3() ShimGteAvsz3()
+#define gte_avsz4() ShimGteAvsz4()
+#define gte_stsxy(r0) ShimGteStsxy((long*)(r0))
+#define gte_stsxy3(r0, r1, r2) ShimGteStsxy3((long*)(r0), (long*)(r1), (long*)(r2))
+#define gte_stsz(r0) ShimGteStsz((long*)(r0))
+#define gte_stsz3(r0, r1, r2) ShimGteStsz3((long*)(r0), (long*)(r1), (long*)(r2))
+#define gte_stopz(r0) ShimGteStopz((long*)(r0))
+#define gte_stotz(r0) ShimGteStotz((long*)(r0))
+#define gte_stflg(r0) ShimGteStflg((long*)(r0))
+#define gte_ldsxy3(r0, r1, r2) ShimGteLdsxy3((long)(r0), (long)(r1), (long)(r2))
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __LIBAPI_SHIM_H
+#define __LIBAPI_SHIM_H
+
+#include "psxshim.h"
+
+#endif
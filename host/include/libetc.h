@@ -0,0 +1,6 @@
+#ifndef __LIBETC_SHIM_H
+#define __LIBETC_SHIM_H
+
+#include "psxshim.h"
+
+#endif
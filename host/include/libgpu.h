@@ -0,0 +1,6 @@
+#ifndef __LIBGPU_SHIM_H
+#define __LIBGPU_SHIM_H
+
+#include "psxshim.h"
+
+#endif
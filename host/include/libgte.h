@@ -0,0 +1,6 @@
+#ifndef __LIBGTE_SHIM_H
+#define __LIBGTE_SHIM_H
+
+#include "psxshim.h"
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef __PSXSHIM_H
+#define __PSXSHIM_H
+
+// Host-side stand-in for the subset of the PsyQ libraries used by the game.
+// Types keep their PsyQ field names so game code compiles unchanged, but layouts follow the host ABI.
+// Primitive tags hold full host pointers (56-bit address + 8-bit length) instead of the console's 24-bit ones.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef unsigned char u_char;
+typedef unsigned short u_short;
+typedef unsigned short ushort;
+typedef unsigned int u_int;
+typedef unsigned long u_long;
+
+#define ONE 4096
+
+// ---- libgte ----
+
+typedef struct {
+    short m[3][3];
+    long t[3];
+} MATRIX;
+
+typedef struct {
+    long vx, vy, vz, pad;
+} VECTOR;
+
+typedef struct {
+    short vx, vy, vz, pad;
+} SVECTOR;
+
+typedef struct {
+    u_char r, g, b, cd;
+} CVECTOR;
+
+typedef struct {
+    short vx, vy;
+} DVECTOR;
+
+#define setVector(v, _x, _y, _z) \
+    (v)->vx = _x, (v)->vy = _y, (v)->vz = _z
+
+#define addVector(v0, v1) \
+    (v0)->vx += (v1)->vx, \
+    (v0)->vy += (v1)->vy, \
+    (v0)->vz += (v1)->vz
+
+#define copyVector(v0, v1) \
+    (v0)->vx = (v1)->vx, \
+    (v0)->vy = (v1)->vy, \
+    (v0)->vz = (v1)->vz
+
+void InitGeom(void);
+void SetGeomOffset(long ofx, long ofy);
+void SetGeomScreen(long h);
+void SetRotMatrix(MATRIX* m);
+void SetTransMatrix(MATRIX* m);
+MATRIX* RotMatrix(SVECTOR* r, MATRIX* m);
+MATRIX* RotMatrix_gte(SVECTOR* r, MATRIX* m);
+MATRIX* TransMatrix(MATRIX* m, VECTOR* v);
+VECTOR* ApplyMatrixLV(MATRIX* m, VECTOR* v0, VECTOR* v1);
+SVECTOR* ApplyMatrixSV(MATRIX* m, SVECTOR* v0, SVECTOR* v1);
+MATRIX* CompMatrixLV(MATRIX* m0, MATRIX* m1, MATRIX* m2);
+MATRIX* MulMatrix0(MATRIX* m0, MATRIX* m1, MATRIX* m2);
+void VectorNormal(VECTOR* v0, VECTOR* v1);
+long SquareRoot0(long a);
+int csin(int a);
+int ccos(int a);
+
+long RotTransPers(SVECTOR* v0, long* sxy, long* p, long* flag);
+long RotTransPers3(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2, long* sxy0, long* sxy1, long* sxy2, long* p, long* flag);
+void RotTrans(SVECTOR* v0, VECTOR* v1, long* flag);
+long RotAverageNclip3(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2, long* sxy0, long* sxy1, long* sxy2, long* p, long* otz, long* flag);
+long RotAverageNclip4(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2, SVECTOR* v3, long* sxy0, long* sxy1, long* sxy2, long* sxy3, long* p, long* otz, long* flag);
+long NormalClip(long sxy0, long sxy1, long sxy2);
+long AverageZ3(long sz0, long sz1, long sz2);
+long AverageZ4(long sz0, long sz1, long sz2, long sz3);
+
+// ---- libgpu ----
+
+typedef struct {
+    short x, y;
+    short w, h;
+} RECT;
+
+typedef struct {
+    u_long mode;
+    RECT* crect;
+    u_long* caddr;
+    RECT* prect;
+    u_long* paddr;
+} TIM_IMAGE;
+
+typedef struct {
+    u_long tag;
+    u_long code[2];
+} DR_MODE;
+
+typedef struct {
+    u_long tag;
+    u_long code[1];
+} DR_TPAGE;
+
+typedef struct {
+    RECT clip;
+    short ofs[2];
+    RECT tw;
+    u_short tpage;
+    u_char dtd;
+    u_char dfe;
+    u_char isbg;
+    u_char r0, g0, b0;
+} DRAWENV;
+
+typedef struct {
+    RECT disp;
+    RECT screen;
+    u_char isinter;
+    u_char isrgb24;
+    u_char pad0, pad1;
+} DISPENV;
+
+typedef struct {
+    unsigned long addr : 56;
+    unsigned long len : 8;
+    u_char r0, g0, b0, code;
+} P_TAG;
+
+typedef struct {
+    u_long tag;
+    u_char r0, g0, b0, code;
+    short x0, y0;
+    short x1, y1;
+    short x2, y2;
+} POLY_F3;
+
+typedef struct {
+    u_long tag;
+    u_char r0, g0, b0, code;
+    short x0, y0;
+    short x1, y1;
+    short x2, y2;
+    short x3, y3;
+} POLY_F4;
+
+typedef struct {
+    u_long tag;
+    u_char r0, g0, b0, code;
+    short x0, y0;
+    u_char u0, v0; u_short clut;
+    short x1, y1;
+    u_char u1, v1; u_short tpage;
+    short x2, y2;
+    u_char u2, v2; u_short pad1;
+} POLY_FT3;
+
+typedef struct {
+    u_long tag;
+    u_char r0, g0, b0, code;
+    short x0, y0;
+    u_char u0, v0; u_short clut;
+    short x1, y1;
+    u_char u1, v1; u_short tpage;
+    short x2, y2;
+    u_char u2, v2; u_short pad1;
+    short x3, y3;
+    u_char u3, v3; u_short pad2;
+} POLY_FT4;
+
+#define SHIM_TAGEND 0xffffffffffffffUL
+
+// Tags are read and written through memcpy, primitives and OT entries are all sorts of types that the compiler
+// would otherwise assume can't alias a P_TAG. The word is laid out like P_TAG's bitfields: addr low, len in the top byte
+static inline u_long ShimGetTag(const void* p) {
+    u_long tag;
+    memcpy(&tag, p, sizeof(tag));
+    return tag;
+}
+
+static inline void ShimSetTag(void* p, u_long tag) {
+    memcpy(p, &tag, sizeof(tag));
+}
+
+#define setlen(p, _len) ShimSetTag(p, (ShimGetTag(p) & SHIM_TAGEND) | ((u_long)(u_char)(_len) << 56))
+#define setaddr(p, _addr) ShimSetTag(p, (ShimGetTag(p) & ~SHIM_TAGEND) | ((u_long)(_addr) & SHIM_TAGEND))
+#define setcode(p, _code) (((u_char*)(p))[offsetof(P_TAG, code)] = (u_char)(_code))
+#define getlen(p) (u_char)(ShimGetTag(p) >> 56)
+#define getcode(p) (((const u_char*)(p))[offsetof(P_TAG, code)])
+#define getaddr(p) (ShimGetTag(p) & SHIM_TAGEND)
+#define nextPrim(p) (void*)(uintptr_t)getaddr(p)
+#define isendprim(p) (getaddr(p) == SHIM_TAGEND)
+#define addPrim(ot, p) setaddr(p, getaddr(ot)), setaddr(ot, p)
+#define addPrims(ot, p0, p1) setaddr(p1, getaddr(ot)), setaddr(ot, p0)
+#define catPrim(p0, p1) setaddr(p0, p1)
+#define termPrim(p) setaddr(p, SHIM_TAGEND)
+
+#define setRGB0(p, _r0, _g0, _b0) (p)->r0 = _r0, (p)->g0 = _g0, (p)->b0 = _b0
+
+#define setUV4(p, _u0, _v0, _u1, _v1, _u2, _v2, _u3, _v3) \
+    (p)->u0 = _u0, (p)->v0 = _v0, (p)->u1 = _u1, (p)->v1 = _v1, \
+    (p)->u2 = _u2, (p)->v2 = _v2, (p)->u3 = _u3, (p)->v3 = _v3
+
+#define setUV3(p, _u0, _v0, _u1, _v1, _u2, _v2) \
+    (p)->u0 = _u0, (p)->v0 = _v0, (p)->u1 = _u1, (p)->v1 = _v1, (p)->u2 = _u2, (p)->v2 = _v2
+
+#define setUVWH(p, _u0, _v0, _w, _h) \
+    (p)->u0 = _u0, (p)->v0 = _v0, \
+    (p)->u1 = (_u0) + (_w), (p)->v1 = _v0, \
+    (p)->u2 = _u0, (p)->v2 = (_v0) + (_h), \
+    (p)->u3 = (_u0) + (_w), (p)->v3 = (_v0) + (_h)
+
+#define setXY4(p, _x0, _y0, _x1, _y1, _x2, _y2, _x3, _y3) \
+    (p)->x0 = _x0, (p)->y0 = _y0, (p)->x1 = _x1, (p)->y1 = _y1, \
+    (p)->x2 = _x2, (p)->y2 = _y2, (p)->x3 = _x3, (p)->y3 = _y3
+
+#define setXY3(p, _x0, _y0, _x1, _y1, _x2, _y2) \
+    (p)->x0 = _x0, (p)->y0 = _y0, (p)->x1 = _x1, (p)->y1 = _y1, (p)->x2 = _x2, (p)->y2 = _y2
+
+#define setRECT(r, _x, _y, _w, _h) \
+    (r)->x = (_x), (r)->y = (_y), (r)->w = (_w), (r)->h = (_h)
+
+#define setPolyF3(p) setlen(p, 4), setcode(p, 0x20)
+#define setPolyF4(p) setlen(p, 5), setcode(p, 0x28)
+#define setPolyFT3(p) setlen(p, 7), setcode(p, 0x24)
+#define setPolyFT4(p) setlen(p, 9), setcode(p, 0x2c)
+
+#define SetPolyF3(p) setPolyF3(p)
+#define SetPolyF4(p) setPolyF4(p)
+#define SetPolyFT3(p) setPolyFT3(p)
+#define SetPolyFT4(p) setPolyFT4(p)
+
+#define getTPage(tp, abr, x, y) \
+    ((((tp) & 0x3) << 7) | (((abr) & 0x3) << 5) | (((y) & 0x100) >> 4) | (((x) & 0x3ff) >> 6) | (((y) & 0x200) << 2))
+
+#define getClut(x, y) (((y) << 6) | (((x) >> 4) & 0x3f))
+
+#define dumpTPage(tpage) ((tpage) & 0xffff)
+
+DRAWENV* SetDefDrawEnv(DRAWENV* env, int x, int y, int w, int h);
+DISPENV* SetDefDispEnv(DISPENV* env, int x, int y, int w, int h);
+DRAWENV* PutDrawEnv(DRAWENV* env);
+DISPENV* PutDispEnv(DISPENV* env);
+int ResetGraph(int mode);
+int SetGraphDebug(int level);
+void SetDispMask(int mask);
+int ClearImage(RECT* rect, u_char r, u_char g, u_char b);
+int LoadImage(RECT* rect, u_long* p);
+int DrawSync(int mode);
+u_long* ClearOTagR(u_long* ot, int n);
+u_long* ClearOTag(u_long* ot, int n);
+void DrawOTag(u_long* p);
+void AddPrim(void* ot, void* p);
+void AddPrims(void* ot, void* p0, void* p1);
+void SetDrawMode(DR_MODE* p, int dfe, int dtd, int tpage, RECT* tw);
+#define setDrawMode(p, dfe, dtd, tpage, tw) SetDrawMode(p, dfe, dtd, tpage, tw)
+u_short GetTPage(int tp, int abr, int x, int y);
+u_short GetClut(int x, int y);
+int OpenTIM(u_long* addr);
+TIM_IMAGE* ReadTIM(TIM_IMAGE* timimg);
+void FntLoad(int tx, int ty);
+int FntOpen(int x, int y, int w, int h, int isbg, int n);
+int FntPrint(const char* fmt, ...);
+u_long* FntFlush(int id);
+void SetDumpFnt(int id);
+
+// ---- libetc ----
+
+#define PADLup     (1 << 12)
+#define PADLdown   (1 << 14)
+#define PADLleft   (1 << 15)
+#define PADLright  (1 << 13)
+#define PADRup     (1 << 4)
+#define PADRdown   (1 << 6)
+#define PADRleft   (1 << 7)
+#define PADRright  (1 << 5)
+#define PADi       (1 << 9)
+#define PADj       (1 << 10)
+#define PADk       (1 << 8)
+#define PADl       (1 << 3)
+#define PADm       (1 << 1)
+#define PADn       (1 << 2)
+#define PADo       (1 << 0)
+#define PADh       (1 << 11)
+#define PADL1      PADn
+#define PADL2      PADo
+#define PADR1      PADl
+#define PADR2      PADm
+#define PADstart   PADh
+#define PADselect  PADk
+
+int VSync(int mode);
+int VSyncCallback(void (*f)(void));
+int DrawSyncCallback(void (*f)(void));
+int ResetCallback(void);
+
+// ---- libapi ----
+
+#define RCntCNT0 0xf2000000
+#define RCntCNT1 0xf2000001
+#define RCntCNT2 0xf2000002
+#define RCntCNT3 0xf2000003
+#define RCntMdINTR 0x1000
+#define RCntMdNOINTR 0x2000
+#define RCntMdSC 0x0001
+#define RCntMdSP 0x0000
+#define RCntMdFR 0x0000
+#define RCntMdGATE 0x0010
+
+void InitHeap(u_long* head, u_long size);
+int InitPAD(char* bufA, long lenA, char* bufB, long lenB);
+int StartPAD(void);
+void StopPAD(void);
+long SetRCnt(u_long spec, u_short target, long mode);
+long GetRCnt(u_long spec);
+long StartRCnt(u_long spec);
+long ResetRCnt(u_long spec);
+void EnterCriticalSection(void);
+void ExitCriticalSection(void);
+
+// ---- Host-only hooks ----
+
+// Returns 0 once the configured number of simulated frames has been run
+int HostFrameContinue(void);
+
+#endif
@@ -0,0 +1,817 @@
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "psxshim.h"
+#include "inline_n.h"
+
+// Software stand-ins for the PsyQ calls the game makes, so the game logic can run headless on a Linux box
+// The GTE part follows the fixed-point behaviour of the real hardware closely enough for culling, sorting and collision
+// The GPU part doesn't rasterise anything, it only walks the ordering tables like the GPU would and counts what it finds
+
+#define SHIM_DEFAULTFRAMES 600
+#define SHIM_MAXOTWALK 1000000 // More links than this in one DrawOTag() means the list loops
+
+// ---- GTE ----
+
+typedef struct ShimGte {
+    MATRIX rot;
+    long trans[3];
+    long ofx;
+    long ofy;
+    long h;
+    long zsf3;
+    long zsf4;
+
+    SVECTOR v[3];
+    short sxy[3][2]; // Screen XY FIFO, [2] is the newest
+    long sz[4];      // Screen Z FIFO, [3] is the newest
+    long mac0;
+    long otz;
+    long flag;
+} ShimGte;
+
+static ShimGte gte;
+static u_long gteTransforms = 0; // Vertices put through RTPS/RTPT, reported per frame with the GPU stats
+
+static long Clamp(long value, long min, long max) {
+    return (value < min) ? min : (value > max) ? max : value;
+}
+
+void InitGeom(void) {
+    memset(&gte, 0, sizeof(gte));
+    gte.h = 1000;
+    gte.zsf3 = 0x155;
+    gte.zsf4 = 0x100;
+}
+
+void SetGeomOffset(long ofx, long ofy) {
+    gte.ofx = ofx;
+    gte.ofy = ofy;
+}
+
+void SetGeomScreen(long h) {
+    gte.h = h;
+}
+
+void SetRotMatrix(MATRIX* m) {
+    memcpy(gte.rot.m, m->m, sizeof(m->m));
+}
+
+void SetTransMatrix(MATRIX* m) {
+    gte.trans[0] = m->t[0];
+    gte.trans[1] = m->t[1];
+    gte.trans[2] = m->t[2];
+}
+
+int csin(int a) {
+    return (int)lround(sin((a & 4095) * (2.0 * M_PI / 4096.0)) * 4096.0);
+}
+
+int ccos(int a) {
+    return (int)lround(cos((a & 4095) * (2.0 * M_PI / 4096.0)) * 4096.0);
+}
+
+static void MulMatrixRaw(short out[3][3], short a[3][3], short b[3][3]) {
+    short result[3][3];
+
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            long sum = 0;
+
+            for (int k = 0; k < 3; k++) {
+                sum += (long)a[r][k] * b[k][c];
+            }
+
+            result[r][c] = (short)(sum >> 12);
+        }
+    }
+
+    memcpy(out, result, sizeof(result));
+}
+
+// Rotation order matches the library: X applied last, so M = Rx * Ry * Rz
+MATRIX* RotMatrix(SVECTOR* r, MATRIX* m) {
+    short sx = csin(r->vx), cx = ccos(r->vx);
+    short sy = csin(r->vy), cy = ccos(r->vy);
+    short sz = csin(r->vz), cz = ccos(r->vz);
+
+    short rx[3][3] = { { ONE, 0, 0 }, { 0, cx, -sx }, { 0, sx, cx } };
+    short ry[3][3] = { { cy, 0, sy }, { 0, ONE, 0 }, { -sy, 0, cy } };
+    short rz[3][3] = { { cz, -sz, 0 }, { sz, cz, 0 }, { 0, 0, ONE } };
+
+    MulMatrixRaw(m->m, ry, rz);
+    MulMatrixRaw(m->m, rx, m->m);
+
+    return m;
+}
+
+MATRIX* RotMatrix_gte(SVECTOR* r, MATRIX* m) {
+    return RotMatrix(r, m);
+}
+
+MATRIX* TransMatrix(MATRIX* m, VECTOR* v) {
+    m->t[0] = v->vx;
+    m->t[1] = v->vy;
+    m->t[2] = v->vz;
+
+    return m;
+}
+
+static void ApplyRaw(short m[3][3], long x, long y, long z, long out[3]) {
+    for (int r = 0; r < 3; r++) {
+        out[r] = ((long)m[r][0] * x + (long)m[r][1] * y + (long)m[r][2] * z) >> 12;
+    }
+}
+
+VECTOR* ApplyMatrixLV(MATRIX* m, VECTOR* v0, VECTOR* v1) {
+    long out[3];
+
+    ApplyRaw(m->m, v0->vx, v0->vy, v0->vz, out);
+    setVector(v1, out[0], out[1], out[2]);
+
+    return v1;
+}
+
+SVECTOR* ApplyMatrixSV(MATRIX* m, SVECTOR* v0, SVECTOR* v1) {
+    long out[3];
+
+    ApplyRaw(m->m, v0->vx, v0->vy, v0->vz, out);
+    setVector(v1, (short)out[0], (short)out[1], (short)out[2]);
+
+    return v1;
+}
+
+MATRIX* CompMatrixLV(MATRIX* m0, MATRIX* m1, MATRIX* m2) {
+    long t[3];
+
+    ApplyRaw(m0->m, m1->t[0], m1->t[1], m1->t[2], t);
+    MulMatrixRaw(m2->m, m0->m, m1->m);
+
+    m2->t[0] = t[0] + m0->t[0];
+    m2->t[1] = t[1] + m0->t[1];
+    m2->t[2] = t[2] + m0->t[2];
+
+    return m2;
+}
+
+MATRIX* MulMatrix0(MATRIX* m0, MATRIX* m1, MATRIX* m2) {
+    MulMatrixRaw(m2->m, m0->m, m1->m);
+    return m2;
+}
+
+void VectorNormal(VECTOR* v0, VECTOR* v1) {
+    double length = sqrt((double)v0->vx * v0->vx + (double)v0->vy * v0->vy + (double)v0->vz * v0->vz);
+
+    if (length == 0.0) {
+        setVector(v1, 0, 0, 0);
+        return;
+    }
+
+    setVector(v1, lround(v0->vx * 4096.0 / length), lround(v0->vy * 4096.0 / length), lround(v0->vz * 4096.0 / length));
+}
+
+long SquareRoot0(long a) {
+    return (a <= 0) ? 0 : (long)sqrt((double)a);
+}
+
+// RTPS for one vertex: rotate, translate and project, pushing the results into the FIFOs
+static void Rtps(SVECTOR* v) {
+    long view[3];
+
+    gteTransforms++;
+
+    ApplyRaw(gte.rot.m, v->vx, v->vy, v->vz, view);
+    view[0] += gte.trans[0];
+    view[1] += gte.trans[1];
+    view[2] += gte.trans[2];
+
+    long z = Clamp(view[2], 0, 0xFFFF);
+
+    if (view[2] < 0 || view[2] > 0xFFFF) {
+        gte.flag |= 1 << 18;
+    }
+
+    // The hardware divide saturates once z drops below half the projection distance
+    long divZ = (z * 2 <= gte.h) ? 0 : z;
+    long sx = (divZ == 0) ? ((view[0] < 0) ? -0x400 : 0x3FF) : gte.ofx + (view[0] * gte.h) / divZ;
+    long sy = (divZ == 0) ? ((view[1] < 0) ? -0x400 : 0x3FF) : gte.ofy + (view[1] * gte.h) / divZ;
+
+    if (divZ == 0) {
+        gte.flag |= 1 << 17;
+    }
+
+    gte.sxy[0][0] = gte.sxy[1][0];
+    gte.sxy[0][1] = gte.sxy[1][1];
+    gte.sxy[1][0] = gte.sxy[2][0];
+    gte.sxy[1][1] = gte.sxy[2][1];
+    gte.sxy[2][0] = (short)Clamp(sx, -0x400, 0x3FF);
+    gte.sxy[2][1] = (short)Clamp(sy, -0x400, 0x3FF);
+
+    gte.sz[0] = gte.sz[1];
+    gte.sz[1] = gte.sz[2];
+    gte.sz[2] = gte.sz[3];
+    gte.sz[3] = z;
+}
+
+static void StoreSxy(long* dst, int index) {
+    // Written as two shorts, because the game passes the address of a primitive's x/y pair
+    ((short*)dst)[0] = gte.sxy[index][0];
+    ((short*)dst)[1] = gte.sxy[index][1];
+}
+
+static long NclipRaw(short a[2], short b[2], short c[2]) {
+    return (long)a[0] * b[1] + (long)b[0] * c[1] + (long)c[0] * a[1]
+        - (long)a[0] * c[1] - (long)b[0] * a[1] - (long)c[0] * b[1];
+}
+
+void ShimGteLdv0(SVECTOR* v) {
+    gte.v[0] = *v;
+}
+
+void ShimGteLdv3(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2) {
+    gte.v[0] = *v0;
+    gte.v[1] = *v1;
+    gte.v[2] = *v2;
+}
+
+void ShimGteRtps(void) {
+    gte.flag = 0;
+    Rtps(&gte.v[0]);
+}
+
+void ShimGteRtpt(void) {
+    gte.flag = 0;
+    Rtps(&gte.v[0]);
+    Rtps(&gte.v[1]);
+    Rtps(&gte.v[2]);
+}
+
+void ShimGteNclip(void) {
+    gte.mac0 = NclipRaw(gte.sxy[0], gte.sxy[1], gte.sxy[2]);
+}
+
+void ShimGteAvsz3(void) {
+    gte.otz = Clamp((gte.zsf3 * (gte.sz[1] + gte.sz[2] + gte.sz[3])) >> 12, 0, 0xFFFF);
+}
+
+void ShimGteAvsz4(void) {
+    gte.otz = Clamp((gte.zsf4 * (gte.sz[0] + gte.sz[1] + gte.sz[2] + gte.sz[3])) >> 12, 0, 0xFFFF);
+}
+
+void ShimGteStsxy(long* sxy) {
+    StoreSxy(sxy, 2);
+}
+
+void ShimGteStsxy3(long* sxy0, long* sxy1, long* sxy2) {
+    StoreSxy(sxy0, 0);
+    StoreSxy(sxy1, 1);
+    StoreSxy(sxy2, 2);
+}
+
+void ShimGteStsz(long* sz) {
+    *sz = gte.sz[3];
+}
+
+void ShimGteStsz3(long* sz0, long* sz1, long* sz2) {
+    *sz0 = gte.sz[1];
+    *sz1 = gte.sz[2];
+    *sz2 = gte.sz[3];
+}
+
+void ShimGteStopz(long* opz) {
+    *opz = gte.mac0;
+}
+
+void ShimGteStotz(long* otz) {
+    *otz = gte.otz;
+}
+
+void ShimGteStflg(long* flg) {
+    *flg = gte.flag;
+}
+
+void ShimGteLdsxy3(long sxy0, long sxy1, long sxy2) {
+    long values[3] = { sxy0, sxy1, sxy2 };
+
+    for (int i = 0; i < 3; i++) {
+        gte.sxy[i][0] = (short)(values[i] & 0xFFFF);
+        gte.sxy[i][1] = (short)((values[i] >> 16) & 0xFFFF);
+    }
+}
+
+long RotTransPers(SVECTOR* v0, long* sxy, long* p, long* flag) {
+    gte.flag = 0;
+    Rtps(v0);
+    StoreSxy(sxy, 2);
+    *p = 0;
+    *flag = gte.flag;
+
+    return gte.sz[3] >> 2;
+}
+
+long RotTransPers3(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2, long* sxy0, long* sxy1, long* sxy2, long* p, long* flag) {
+    ShimGteLdv3(v0, v1, v2);
+    ShimGteRtpt();
+    ShimGteStsxy3(sxy0, sxy1, sxy2);
+    ShimGteAvsz3();
+    *p = 0;
+    *flag = gte.flag;
+
+    return gte.otz;
+}
+
+void RotTrans(SVECTOR* v0, VECTOR* v1, long* flag) {
+    long view[3];
+
+    ApplyRaw(gte.rot.m, v0->vx, v0->vy, v0->vz, view);
+    setVector(v1, view[0] + gte.trans[0], view[1] + gte.trans[1], view[2] + gte.trans[2]);
+    *flag = 0;
+}
+
+long RotAverageNclip3(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2, long* sxy0, long* sxy1, long* sxy2, long* p, long* otz, long* flag) {
+    ShimGteLdv3(v0, v1, v2);
+    ShimGteRtpt();
+    ShimGteNclip();
+
+    long nclip = gte.mac0;
+    *flag = gte.flag;
+    *p = 0;
+
+    if (nclip <= 0) {
+        return nclip;
+    }
+
+    ShimGteStsxy3(sxy0, sxy1, sxy2);
+    ShimGteAvsz3();
+    *otz = gte.otz;
+
+    return nclip;
+}
+
+long RotAverageNclip4(SVECTOR* v0, SVECTOR* v1, SVECTOR* v2, SVECTOR* v3, long* sxy0, long* sxy1, long* sxy2, long* sxy3, long* p, long* otz, long* flag) {
+    ShimGteLdv3(v0, v1, v2);
+    ShimGteRtpt();
+    ShimGteNclip();
+
+    long nclip = gte.mac0;
+    long flag0 = gte.flag;
+    *p = 0;
+
+    if (nclip <= 0) {
+        *flag = flag0;
+        return nclip;
+    }
+
+    ShimGteStsxy3(sxy0, sxy1, sxy2);
+
+    gte.flag = 0;
+    Rtps(v3);
+    StoreSxy(sxy3, 2);
+    *flag = flag0 | gte.flag;
+
+    ShimGteAvsz4();
+    *otz = gte.otz;
+
+    return nclip;
+}
+
+long NormalClip(long sxy0, long sxy1, long sxy2) {
+    ShimGteLdsxy3(sxy0, sxy1, sxy2);
+    ShimGteNclip();
+
+    return gte.mac0;
+}
+
+long AverageZ3(long sz0, long sz1, long sz2) {
+    return Clamp((gte.zsf3 * (sz0 + sz1 + sz2)) >> 12, 0, 0xFFFF);
+}
+
+long AverageZ4(long sz0, long sz1, long sz2, long sz3) {
+    return Clamp((gte.zsf4 * (sz0 + sz1 + sz2 + sz3)) >> 12, 0, 0xFFFF);
+}
+
+// ---- GPU ----
+
+typedef struct ShimGpuStats {
+    u_long frames;
+    u_long prims;
+    u_long tpageSwitches;
+    u_long modeChanges;
+    u_long imageBytes;
+    u_long images;
+    u_long drawSyncs;
+} ShimGpuStats;
+
+static ShimGpuStats gpuStats;
+static u_short vram[512][1024];
+static char fontText[4096];
+static size_t fontLength = 0;
+static u_long* timCursor = NULL;
+
+static void PrintGpuStats(void) {
+    if (gpuStats.frames == 0) {
+        return;
+    }
+
+    printf("gpu: %lu frames, %.1f prims/frame, %.1f tpage switches/frame, %lu bytes uploaded\n",
+        gpuStats.frames,
+        (double)gpuStats.prims / gpuStats.frames,
+        (double)gpuStats.tpageSwitches / gpuStats.frames,
+        gpuStats.imageBytes);
+    printf("gpu: %.1f draw mode changes/frame\n", (double)gpuStats.modeChanges / gpuStats.frames);
+    printf("gpu: %lu image uploads, %lu DrawSync waits\n", gpuStats.images, gpuStats.drawSyncs);
+    printf("gte: %.1f vertex transforms/frame\n", (double)gteTransforms / gpuStats.frames);
+}
+
+DRAWENV* SetDefDrawEnv(DRAWENV* env, int x, int y, int w, int h) {
+    memset(env, 0, sizeof(DRAWENV));
+    setRECT(&env->clip, x, y, w, h);
+    env->ofs[0] = x;
+    env->ofs[1] = y;
+    env->dtd = 1;
+
+    return env;
+}
+
+DISPENV* SetDefDispEnv(DISPENV* env, int x, int y, int w, int h) {
+    memset(env, 0, sizeof(DISPENV));
+    setRECT(&env->disp, x, y, w, h);
+
+    return env;
+}
+
+DRAWENV* PutDrawEnv(DRAWENV* env) {
+    return env;
+}
+
+DISPENV* PutDispEnv(DISPENV* env) {
+    return env;
+}
+
+int ResetGraph(int mode) {
+    static int registered = 0;
+
+    (void)mode;
+
+    if (!registered) {
+        atexit(PrintGpuStats);
+        registered = 1;
+    }
+
+    return 0;
+}
+
+int SetGraphDebug(int level) {
+    return level;
+}
+
+void SetDispMask(int mask) {
+    (void)mask;
+}
+
+int ClearImage(RECT* rect, u_char r, u_char g, u_char b) {
+    u_short colour = (r >> 3) | ((g >> 3) << 5) | ((b >> 3) << 10);
+
+    for (int y = rect->y; y < rect->y + rect->h && y < 512; y++) {
+        for (int x = rect->x; x < rect->x + rect->w && x < 1024; x++) {
+            vram[y][x] = colour;
+        }
+    }
+
+    return 0;
+}
+
+int LoadImage(RECT* rect, u_long* p) {
+    const u_short* src = (const u_short*)p;
+
+    if (rect->x < 0 || rect->y < 0 || rect->x + rect->w > 1024 || rect->y + rect->h > 512) {
+        fprintf(stderr, "shim: LoadImage outside of VRAM (%d, %d, %d, %d)\n", rect->x, rect->y, rect->w, rect->h);
+        return 0;
+    }
+
+    for (int y = 0; y < rect->h; y++) {
+        memcpy(&vram[rect->y + y][rect->x], &src[y * rect->w], rect->w * sizeof(u_short));
+    }
+
+    gpuStats.imageBytes += rect->w * rect->h * sizeof(u_short);
+    gpuStats.images++;
+
+    return 0;
+}
+
+int DrawSync(int mode) {
+    if (mode == 0) {
+        gpuStats.drawSyncs++;
+    }
+
+    return 0;
+}
+
+u_long* ClearOTagR(u_long* ot, int n) {
+    termPrim(&ot[0]);
+    setlen(&ot[0], 0);
+
+    for (int i = 1; i < n; i++) {
+        setaddr(&ot[i], &ot[i - 1]);
+        setlen(&ot[i], 0);
+    }
+
+    return ot;
+}
+
+u_long* ClearOTag(u_long* ot, int n) {
+    for (int i = 0; i < n - 1; i++) {
+        setaddr(&ot[i], &ot[i + 1]);
+        setlen(&ot[i], 0);
+    }
+
+    termPrim(&ot[n - 1]);
+    setlen(&ot[n - 1], 0);
+
+    return ot;
+}
+
+// Walks the list the way the GPU's DMA would, counting primitives and texture page changes
+void DrawOTag(u_long* p) {
+    P_TAG* tag = (P_TAG*)p;
+    int lastTPage = -1;
+    size_t links = 0;
+
+    while (!isendprim(tag)) {
+        if (++links > SHIM_MAXOTWALK) {
+            fprintf(stderr, "shim: DrawOTag walked %d links, the ordering table loops\n", SHIM_MAXOTWALK);
+            abort();
+        }
+
+        if (getlen(tag) > 0 && getcode(tag) == 0xE1) {
+            gpuStats.modeChanges++;
+        }
+        else if (getlen(tag) > 0) {
+            gpuStats.prims++;
+
+            u_char code = getcode(tag) & 0xFC;
+            int tpage = -1;
+
+            if (code == 0x2C) {
+                tpage = ((POLY_FT4*)tag)->tpage;
+            }
+            else if (code == 0x24) {
+                tpage = ((POLY_FT3*)tag)->tpage;
+            }
+
+            if (tpage != -1 && tpage != lastTPage) {
+                gpuStats.tpageSwitches++;
+                lastTPage = tpage;
+            }
+        }
+
+        tag = (P_TAG*)nextPrim(tag);
+    }
+
+    gpuStats.frames++;
+}
+
+void AddPrim(void* ot, void* p) {
+    addPrim(ot, p);
+}
+
+void AddPrims(void* ot, void* p0, void* p1) {
+    addPrims(ot, p0, p1);
+}
+
+void SetDrawMode(DR_MODE* p, int dfe, int dtd, int tpage, RECT* tw) {
+    setlen(p, 2);
+    setcode(p, 0xE1);
+    p->code[0] = 0xE1000000 | ((dtd & 1) << 9) | ((dfe & 1) << 10) | (tpage & 0x9FF);
+
+    if (tw != NULL) {
+        p->code[1] = 0xE2000000 | ((tw->w ? (~(tw->w - 1) & 0xFF) >> 3 : 0))
+            | ((tw->h ? (~(tw->h - 1) & 0xFF) >> 3 : 0) << 5)
+            | (((tw->x >> 3) & 0x1F) << 10)
+            | (((tw->y >> 3) & 0x1F) << 15);
+    }
+    else {
+        p->code[1] = 0xE2000000;
+    }
+}
+
+u_short GetTPage(int tp, int abr, int x, int y) {
+    return getTPage(tp, abr, x, y);
+}
+
+u_short GetClut(int x, int y) {
+    return getClut(x, y);
+}
+
+// TIM files are sequences of 32-bit words, regardless of the host's long size
+int OpenTIM(u_long* addr) {
+    timCursor = addr;
+    return 0;
+}
+
+TIM_IMAGE* ReadTIM(TIM_IMAGE* timimg) {
+    uint32_t* words = (uint32_t*)timCursor;
+
+    if (words == NULL || words[0] != 0x10) {
+        return NULL;
+    }
+
+    timimg->mode = words[1];
+    words += 2;
+
+    if (timimg->mode & 0x8) {
+        uint32_t clutBytes = words[0];
+        timimg->crect = (RECT*)&words[1];
+        timimg->caddr = (u_long*)&words[3];
+        words += clutBytes / 4;
+    }
+    else {
+        timimg->crect = NULL;
+        timimg->caddr = NULL;
+    }
+
+    uint32_t pixelBytes = words[0];
+    timimg->prect = (RECT*)&words[1];
+    timimg->paddr = (u_long*)&words[3];
+    words += pixelBytes / 4;
+
+    timCursor = (u_long*)words;
+
+    return timimg;
+}
+
+void FntLoad(int tx, int ty) {
+    (void)tx;
+    (void)ty;
+}
+
+int FntOpen(int x, int y, int w, int h, int isbg, int n) {
+    (void)x; (void)y; (void)w; (void)h; (void)isbg; (void)n;
+    return 0;
+}
+
+int FntPrint(const char* fmt, ...) {
+    va_list args;
+    int written;
+
+    va_start(args, fmt);
+    written = vsnprintf(&fontText[fontLength], sizeof(fontText) - fontLength, fmt, args);
+    va_end(args);
+
+    if (written > 0) {
+        fontLength += written;
+
+        if (fontLength >= sizeof(fontText)) {
+            fontLength = sizeof(fontText) - 1;
+        }
+    }
+
+    return written;
+}
+
+u_long* FntFlush(int id) {
+    (void)id;
+
+    if (getenv("PSX_HUD") != NULL && fontLength > 0) {
+        fputs(fontText, stdout);
+    }
+
+    fontLength = 0;
+    fontText[0] = 0;
+
+    return NULL;
+}
+
+void SetDumpFnt(int id) {
+    (void)id;
+}
+
+// ---- ETC ----
+
+static void (*vsyncCallback)(void) = NULL;
+static int vsyncCount = 0;
+
+// Headless, so time only passes when the game waits for or polls the vertical blank
+int VSync(int mode) {
+    (void)mode;
+
+    vsyncCount++;
+
+    if (vsyncCallback != NULL) {
+        vsyncCallback();
+    }
+
+    return vsyncCount;
+}
+
+int VSyncCallback(void (*f)(void)) {
+    vsyncCallback = f;
+    return 0;
+}
+
+int DrawSyncCallback(void (*f)(void)) {
+    (void)f;
+    return 0;
+}
+
+int ResetCallback(void) {
+    return 0;
+}
+
+// ---- API ----
+
+static char* padBuffers[2] = { NULL, NULL };
+
+void InitHeap(u_long* head, u_long size) {
+    (void)head;
+    (void)size;
+}
+
+// A connected analogue pad with nothing pressed and both sticks centred
+static void IdlePad(char* buffer) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    buffer[0] = 0x00;
+    buffer[1] = 0x73;
+    buffer[2] = (char)0xFF;
+    buffer[3] = (char)0xFF;
+    buffer[4] = (char)0x80;
+    buffer[5] = (char)0x80;
+    buffer[6] = (char)0x80;
+    buffer[7] = (char)0x80;
+}
+
+int InitPAD(char* bufA, long lenA, char* bufB, long lenB) {
+    (void)lenA;
+    (void)lenB;
+
+    padBuffers[0] = bufA;
+    padBuffers[1] = bufB;
+    IdlePad(bufA);
+    IdlePad(bufB);
+
+    return 1;
+}
+
+int StartPAD(void) {
+    return 1;
+}
+
+void StopPAD(void) {
+}
+
+long SetRCnt(u_long spec, u_short target, long mode) {
+    (void)spec;
+    (void)target;
+    (void)mode;
+    return 1;
+}
+
+// Every counter ticks once per 100 ns of host time, see PROFILERTICKNS
+long GetRCnt(u_long spec) {
+    struct timespec ts;
+
+    (void)spec;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (long)(((u_long)ts.tv_sec * 10000000UL + (u_long)ts.tv_nsec / 100) & 0xFFFF);
+}
+
+long StartRCnt(u_long spec) {
+    (void)spec;
+    return 1;
+}
+
+long ResetRCnt(u_long spec) {
+    (void)spec;
+    return 1;
+}
+
+void EnterCriticalSection(void) {
+}
+
+void ExitCriticalSection(void) {
+}
+
+// ---- Host ----
+
+int HostFrameContinue(void) {
+    static long framesLeft = -1;
+
+    if (framesLeft < 0) {
+        const char* frames = getenv("PSX_FRAMES");
+        framesLeft = (frames != NULL) ? atol(frames) : SHIM_DEFAULTFRAMES;
+    }
+
+    if (framesLeft == 0) {
+        return 0;
+    }
+
+    framesLeft--;
+    return 1;
+}
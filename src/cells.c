@@ -0,0 +1,183 @@
+#include <string.h>
+
+#include "cells.h"
+#include "graphics.h"
+
+#define CELLPROJECTION (RENDERX / 2) // Projection plane distance, same as InitGraphics() gives the GTE
+
+// Index of a cell in visible and reached
+static size_t Slot(const CellGraph* graph, u_char cell) {
+    return (cell == LEVELOUTSIDE) ? graph->cellCount : cell;
+}
+
+// Takes the cells and portals of a level, checking every portal leads between two different known cells
+bool CellsAttach(CellGraph* graph, const LevelCell* cells, size_t cellCount, const LevelPortal* portals, size_t portalCount) {
+    if (cellCount > CELLMAX) {
+        return false;
+    }
+
+    for (size_t i = 0; i < portalCount; i++) {
+        for (size_t side = 0; side < 2; side++) {
+            if (portals[i].cells[side] >= cellCount && portals[i].cells[side] != LEVELOUTSIDE) {
+                return false;
+            }
+        }
+
+        if (portals[i].cells[0] == portals[i].cells[1]) {
+            return false;
+        }
+    }
+
+    CellsClear(graph);
+    graph->cells = cells;
+    graph->cellCount = cellCount;
+    graph->portals = portals;
+    graph->portalCount = portalCount;
+
+    return true;
+}
+
+// Back to no cells, where only the outside exists and is always visible
+void CellsClear(CellGraph* graph) {
+    memset(graph, 0, sizeof(CellGraph));
+    graph->cameraCell = LEVELOUTSIDE;
+    graph->visible[0] = true;
+}
+
+// First cell containing position, or LEVELOUTSIDE
+u_char CellsLocate(const CellGraph* graph, const VECTOR* position) {
+    for (size_t i = 0; i < graph->cellCount; i++) {
+        const LevelCell* cell = &graph->cells[i];
+
+        if (position->vx >= cell->mins[0] && position->vx <= cell->maxs[0]
+            && position->vy >= cell->mins[1] && position->vy <= cell->maxs[1]
+            && position->vz >= cell->mins[2] && position->vz <= cell->maxs[2]) {
+            return i;
+        }
+    }
+
+    return LEVELOUTSIDE;
+}
+
+static long Clamp(long value, long min, long max) {
+    return (value < min) ? min : (value > max) ? max : value;
+}
+
+// Screen rect around a portal. Returns false if it's entirely behind the camera
+// Portals the camera is about to step through can't be projected reliably, so they cover the whole screen
+static bool ProjectPortal(const LevelPortal* portal, MATRIX* camera, CellRect* rect) {
+    VECTOR view[4];
+    size_t behind = 0;
+    bool near = false;
+
+    for (size_t k = 0; k < 4; k++) {
+        VECTOR world = { portal->corners[k][0], portal->corners[k][1], portal->corners[k][2], 0 };
+
+        ApplyMatrixLV(camera, &world, &view[k]);
+        view[k].vx += camera->t[0];
+        view[k].vy += camera->t[1];
+        view[k].vz += camera->t[2];
+
+        behind += view[k].vz <= 0;
+        near |= view[k].vz < CELLPORTALNEAR;
+    }
+
+    if (behind == 4) {
+        return false;
+    }
+
+    if (near) {
+        rect->x0 = 0;
+        rect->y0 = 0;
+        rect->x1 = RENDERX;
+        rect->y1 = RENDERY;
+        return true;
+    }
+
+    long x0 = RENDERX;
+    long y0 = RENDERY;
+    long x1 = 0;
+    long y1 = 0;
+
+    for (size_t k = 0; k < 4; k++) {
+        long sx = Clamp((RENDERX / 2) + (view[k].vx * CELLPROJECTION) / view[k].vz, 0, RENDERX);
+        long sy = Clamp((RENDERY / 2) + (view[k].vy * CELLPROJECTION) / view[k].vz, 0, RENDERY);
+
+        x0 = (sx < x0) ? sx : x0;
+        y0 = (sy < y0) ? sy : y0;
+        x1 = (sx > x1) ? sx : x1;
+        y1 = (sy > y1) ? sy : y1;
+    }
+
+    rect->x0 = x0;
+    rect->y0 = y0;
+    rect->x1 = x1;
+    rect->y1 = y1;
+
+    return true;
+}
+
+// Marks cell visible through rect, then follows its portals with rect narrowed down to each of them
+static void Flood(CellGraph* graph, MATRIX* camera, u_char cell, const CellRect* rect, size_t depth) {
+    size_t slot = Slot(graph, cell);
+    CellRect* reached = &graph->reached[slot];
+
+    if (graph->visible[slot]) {
+        // Nothing new can show through its portals unless rect reaches past what it was already seen through
+        if (rect->x0 >= reached->x0 && rect->y0 >= reached->y0 && rect->x1 <= reached->x1 && rect->y1 <= reached->y1) {
+            return;
+        }
+
+        reached->x0 = (rect->x0 < reached->x0) ? rect->x0 : reached->x0;
+        reached->y0 = (rect->y0 < reached->y0) ? rect->y0 : reached->y0;
+        reached->x1 = (rect->x1 > reached->x1) ? rect->x1 : reached->x1;
+        reached->y1 = (rect->y1 > reached->y1) ? rect->y1 : reached->y1;
+    }
+    else {
+        graph->visible[slot] = true;
+        *reached = *rect;
+    }
+
+    if (depth == CELLMAXDEPTH) {
+        return;
+    }
+
+    for (size_t i = 0; i < graph->portalCount; i++) {
+        const LevelPortal* portal = &graph->portals[i];
+        CellRect through;
+
+        if (portal->cells[0] != cell && portal->cells[1] != cell) {
+            continue;
+        }
+
+        if (!ProjectPortal(portal, camera, &through)) {
+            continue;
+        }
+
+        through.x0 = (rect->x0 > through.x0) ? rect->x0 : through.x0;
+        through.y0 = (rect->y0 > through.y0) ? rect->y0 : through.y0;
+        through.x1 = (rect->x1 < through.x1) ? rect->x1 : through.x1;
+        through.y1 = (rect->y1 < through.y1) ? rect->y1 : through.y1;
+
+        if (through.x0 >= through.x1 || through.y0 >= through.y1) {
+            continue;
+        }
+
+        Flood(graph, camera, (portal->cells[0] == cell) ? portal->cells[1] : portal->cells[0], &through, depth + 1);
+    }
+}
+
+// Works out which cells the camera sees this frame: its own, and every one a chain of portals on screen leads to
+// camera is the world to view transform, eye the camera's world position
+void CellsUpdateVisibility(CellGraph* graph, MATRIX* camera, const VECTOR* eye) {
+    CellRect screen = { 0, 0, RENDERX, RENDERY };
+
+    memset(graph->visible, 0, sizeof(graph->visible));
+    graph->cameraCell = CellsLocate(graph, eye);
+    Flood(graph, camera, graph->cameraCell, &screen, 0);
+}
+
+// LEVELNOCELL objects are always visible, as far as cells go
+bool CellsIsVisible(const CellGraph* graph, u_char cell) {
+    return cell == LEVELNOCELL || graph->visible[Slot(graph, cell)];
+}
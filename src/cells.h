@@ -0,0 +1,41 @@
+#ifndef __CELLS_H
+#define __CELLS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <libgte.h>
+
+#include "level.h"
+
+#define CELLMAX 32        // Cells a level can have, the outside not counted
+#define CELLMAXDEPTH 8    // Portals a view is followed through one after another
+#define CELLPORTALNEAR 16 // Portals with a corner closer to the camera than this aren't projected, they keep the whole view
+
+// Screen space rectangle a cell is seen through, x1 and y1 excluded
+typedef struct CellRect {
+    short x0;
+    short y0;
+    short x1;
+    short y1;
+} CellRect;
+
+// Cells and portals of a level, used in place from its image, and which of them the camera sees this frame
+// The outside takes slot cellCount in visible and reached
+typedef struct CellGraph {
+    const LevelCell* cells;
+    const LevelPortal* portals;
+    size_t cellCount;
+    size_t portalCount;
+
+    u_char cameraCell;
+    bool visible[CELLMAX + 1];
+    CellRect reached[CELLMAX + 1]; // Union of the rects each visible cell was reached through
+} CellGraph;
+
+bool CellsAttach(CellGraph* graph, const LevelCell* cells, size_t cellCount, const LevelPortal* portals, size_t portalCount);
+void CellsClear(CellGraph* graph);
+u_char CellsLocate(const CellGraph* graph, const VECTOR* position);
+void CellsUpdateVisibility(CellGraph* graph, MATRIX* camera, const VECTOR* eye);
+bool CellsIsVisible(const CellGraph* graph, u_char cell);
+
+#endif
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "colgrid.h"
+
+// Converts a world coordinate to a cell coordinate, clamped to the grid
+static long CellCoord(long value, long origin, unsigned char shift, unsigned short cells) {
+    long cell = (value - origin) >> shift;
+
+    if (cell < 0) {
+        return 0;
+    }
+    if (cell >= cells) {
+        return cells - 1;
+    }
+
+    return cell;
+}
+
+bool ColGridBuild(ColGrid* grid, const ColGridBounds* boxes, size_t boxCount) {
+    memset(grid, 0, sizeof(ColGrid));
+    grid->ownsArrays = true;
+
+    if (boxCount == 0) {
+        return true;
+    }
+
+    long minX = boxes[0].minX;
+    long minZ = boxes[0].minZ;
+    long maxX = boxes[0].maxX;
+    long maxZ = boxes[0].maxZ;
+
+    for (size_t i = 1; i < boxCount; i++) {
+        if (boxes[i].minX < minX) minX = boxes[i].minX;
+        if (boxes[i].minZ < minZ) minZ = boxes[i].minZ;
+        if (boxes[i].maxX > maxX) maxX = boxes[i].maxX;
+        if (boxes[i].maxZ > maxZ) maxZ = boxes[i].maxZ;
+    }
+
+    grid->originX = minX;
+    grid->originZ = minZ;
+    grid->cellShift = COLGRIDCELLSHIFT;
+
+    // Widen the cells until the whole level fits in the cell budget
+    while (1) {
+        long cellsX = ((maxX - minX) >> grid->cellShift) + 1;
+        long cellsZ = ((maxZ - minZ) >> grid->cellShift) + 1;
+
+        if (cellsX * cellsZ <= COLGRIDMAXCELLS) {
+            grid->cellsX = cellsX;
+            grid->cellsZ = cellsZ;
+            break;
+        }
+
+        grid->cellShift++;
+    }
+
+    size_t cellCount = grid->cellsX * grid->cellsZ;
+
+    // First pass counts the boxes per cell, the prefix sum turns counts into start offsets, second pass fills
+    grid->cellStart = calloc(cellCount + 1, sizeof(unsigned short));
+    grid->boxStamps = calloc(boxCount, sizeof(unsigned short));
+
+    if (grid->cellStart == NULL || grid->boxStamps == NULL) {
+        ColGridFree(grid);
+        return false;
+    }
+
+    size_t itemCount = 0;
+
+    for (size_t i = 0; i < boxCount; i++) {
+        long x0 = CellCoord(boxes[i].minX, grid->originX, grid->cellShift, grid->cellsX);
+        long x1 = CellCoord(boxes[i].maxX, grid->originX, grid->cellShift, grid->cellsX);
+        long z0 = CellCoord(boxes[i].minZ, grid->originZ, grid->cellShift, grid->cellsZ);
+        long z1 = CellCoord(boxes[i].maxZ, grid->originZ, grid->cellShift, grid->cellsZ);
+
+        for (long z = z0; z <= z1; z++) {
+            for (long x = x0; x <= x1; x++) {
+                grid->cellStart[(z * grid->cellsX) + x + 1]++;
+                itemCount++;
+            }
+        }
+    }
+
+    for (size_t c = 0; c < cellCount; c++) {
+        grid->cellStart[c + 1] += grid->cellStart[c];
+    }
+
+    grid->items = malloc(itemCount * sizeof(unsigned short));
+    unsigned short* fill = calloc(cellCount, sizeof(unsigned short));
+
+    if (grid->items == NULL || fill == NULL) {
+        free(fill);
+        ColGridFree(grid);
+        return false;
+    }
+
+    for (size_t i = 0; i < boxCount; i++) {
+        long x0 = CellCoord(boxes[i].minX, grid->originX, grid->cellShift, grid->cellsX);
+        long x1 = CellCoord(boxes[i].maxX, grid->originX, grid->cellShift, grid->cellsX);
+        long z0 = CellCoord(boxes[i].minZ, grid->originZ, grid->cellShift, grid->cellsZ);
+        long z1 = CellCoord(boxes[i].maxZ, grid->originZ, grid->cellShift, grid->cellsZ);
+
+        for (long z = z0; z <= z1; z++) {
+            for (long x = x0; x <= x1; x++) {
+                size_t c = (z * grid->cellsX) + x;
+                grid->items[grid->cellStart[c] + fill[c]] = i;
+                fill[c]++;
+            }
+        }
+    }
+
+    free(fill);
+    grid->boxCount = boxCount;
+
+    return true;
+}
+
+// Uses a grid prebuilt by the level compiler without copying it. boxStamps has to hold boxCount entries
+// The image is checked first, so a broken one can't send queries outside of its arrays
+bool ColGridAttach(ColGrid* grid, const ColGridImage* image, size_t imageSize, unsigned short* boxStamps, size_t boxCount) {
+    memset(grid, 0, sizeof(ColGrid));
+
+    if (imageSize < sizeof(ColGridImage)) {
+        return false;
+    }
+
+    size_t cellCount = image->cellsX * image->cellsZ;
+
+    if (cellCount == 0 || cellCount > COLGRIDMAXCELLS
+        || imageSize < sizeof(ColGridImage) + (cellCount + 1 + image->itemCount) * sizeof(unsigned short)) {
+        return false;
+    }
+
+    unsigned short* cellStart = (unsigned short*)(image + 1);
+    unsigned short* items = cellStart + cellCount + 1;
+
+    if (cellStart[0] != 0 || cellStart[cellCount] != image->itemCount) {
+        return false;
+    }
+
+    for (size_t c = 0; c < cellCount; c++) {
+        if (cellStart[c] > cellStart[c + 1]) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < image->itemCount; i++) {
+        if (items[i] >= boxCount) {
+            return false;
+        }
+    }
+
+    grid->originX = image->originX;
+    grid->originZ = image->originZ;
+    grid->cellShift = image->cellShift;
+    grid->cellsX = image->cellsX;
+    grid->cellsZ = image->cellsZ;
+    grid->cellStart = cellStart;
+    grid->items = items;
+    grid->boxStamps = boxStamps;
+    grid->boxCount = boxCount;
+    memset(boxStamps, 0, boxCount * sizeof(unsigned short));
+
+    return true;
+}
+
+// Bytes ColGridWriteImage() needs for this grid, including the arrays that follow the image header
+size_t ColGridImageSize(const ColGrid* grid) {
+    size_t cellCount = grid->cellsX * grid->cellsZ;
+
+    return sizeof(ColGridImage) + (cellCount + 1 + grid->cellStart[cellCount]) * sizeof(unsigned short);
+}
+
+void ColGridWriteImage(const ColGrid* grid, ColGridImage* image) {
+    size_t cellCount = grid->cellsX * grid->cellsZ;
+    unsigned short* cellStart = (unsigned short*)(image + 1);
+
+    memset(image, 0, sizeof(ColGridImage));
+    image->originX = grid->originX;
+    image->originZ = grid->originZ;
+    image->cellsX = grid->cellsX;
+    image->cellsZ = grid->cellsZ;
+    image->itemCount = grid->cellStart[cellCount];
+    image->cellShift = grid->cellShift;
+
+    memcpy(cellStart, grid->cellStart, (cellCount + 1) * sizeof(unsigned short));
+    memcpy(cellStart + cellCount + 1, grid->items, image->itemCount * sizeof(unsigned short));
+}
+
+// Grids attached to a level image only had their stamps handed in, the owner of those frees them
+void ColGridFree(ColGrid* grid) {
+    if (grid->ownsArrays) {
+        free(grid->cellStart);
+        free(grid->items);
+        free(grid->boxStamps);
+    }
+
+    memset(grid, 0, sizeof(ColGrid));
+}
+
+// Writes the index of every box whose cells overlap the given XZ rectangle into results, in ascending order
+// Only the cells under the rectangle are visited, so the cost doesn't depend on the total number of boxes
+// Returns how many boxes matched. If that's more than maxResults, only the lowest maxResults of them were written
+size_t ColGridQuery(ColGrid* grid, long minX, long minZ, long maxX, long maxZ, unsigned short* results, size_t maxResults) {
+    size_t count = 0;
+
+    if (grid->boxCount == 0) {
+        return 0;
+    }
+
+    // Anything completely outside of the grid can't touch a box
+    if (maxX < grid->originX || maxZ < grid->originZ
+        || ((minX - grid->originX) >> grid->cellShift) >= grid->cellsX
+        || ((minZ - grid->originZ) >> grid->cellShift) >= grid->cellsZ) {
+        
+        return 0;
+    }
+
+    grid->queryStamp++;
+
+    // Stamp wrapped around, so old stamps could match again
+    if (grid->queryStamp == 0) {
+        memset(grid->boxStamps, 0, grid->boxCount * sizeof(unsigned short));
+        grid->queryStamp = 1;
+    }
+
+    long x0 = CellCoord(minX, grid->originX, grid->cellShift, grid->cellsX);
+    long x1 = CellCoord(maxX, grid->originX, grid->cellShift, grid->cellsX);
+    long z0 = CellCoord(minZ, grid->originZ, grid->cellShift, grid->cellsZ);
+    long z1 = CellCoord(maxZ, grid->originZ, grid->cellShift, grid->cellsZ);
+
+    for (long z = z0; z <= z1; z++) {
+        for (long x = x0; x <= x1; x++) {
+            size_t c = (z * grid->cellsX) + x;
+
+            for (size_t i = grid->cellStart[c]; i < grid->cellStart[c + 1]; i++) {
+                unsigned short box = grid->items[i];
+
+                if (grid->boxStamps[box] == grid->queryStamp) {
+                    continue;
+                }
+
+                grid->boxStamps[box] = grid->queryStamp;
+                count++;
+
+                // Full, a lower box still pushes the highest one out so results stay the first maxResults
+                if (count > maxResults && (maxResults == 0 || box > results[maxResults - 1])) {
+                    continue;
+                }
+
+                // Insertion sort keeps boxes in level order, so collision is resolved in the same order as a linear scan
+                size_t pos = (count > maxResults) ? maxResults - 1 : count - 1;
+                while (pos > 0 && results[pos - 1] > box) {
+                    results[pos] = results[pos - 1];
+                    pos--;
+                }
+
+                results[pos] = box;
+            }
+        }
+    }
+
+    return count;
+}
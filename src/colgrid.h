@@ -0,0 +1,59 @@
+#ifndef __COLGRID_H
+#define __COLGRID_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Kept free of PsyQ types so the grid can also be built and benchmarked on the host (see tools/colgridbench.c)
+
+#define COLGRIDCELLSHIFT 7 // 128 world units per cell side. Grown at build time if the level would need too many cells
+#define COLGRIDMAXCELLS 1024
+
+// XZ footprint of a collision box, in world units
+typedef struct ColGridBounds {
+    long minX;
+    long minZ;
+    long maxX;
+    long maxZ;
+} ColGridBounds;
+
+// Static uniform grid over the XZ plane, built once per level
+// Cell c holds the box indices items[cellStart[c]] up to (not including) items[cellStart[c + 1]]
+typedef struct ColGrid {
+    long originX;
+    long originZ;
+    unsigned char cellShift;
+    unsigned short cellsX;
+    unsigned short cellsZ;
+
+    unsigned short* cellStart;
+    unsigned short* items;
+
+    // Last query each box was returned by, so boxes spanning several cells are only returned once
+    unsigned short* boxStamps;
+    unsigned short queryStamp;
+    size_t boxCount;
+
+    bool ownsArrays; // False when cellStart and items live in a level image
+} ColGrid;
+
+// Prebuilt grid as stored in level files, see tools/levelc.c. Fixed-size fields, so the host reads it the same way
+// Followed by unsigned short cellStart[cellsX * cellsZ + 1], then unsigned short items[itemCount]
+typedef struct ColGridImage {
+    int originX;
+    int originZ;
+    unsigned short cellsX;
+    unsigned short cellsZ;
+    unsigned short itemCount;
+    unsigned char cellShift;
+    unsigned char pad;
+} ColGridImage;
+
+bool ColGridBuild(ColGrid* grid, const ColGridBounds* boxes, size_t boxCount);
+bool ColGridAttach(ColGrid* grid, const ColGridImage* image, size_t imageSize, unsigned short* boxStamps, size_t boxCount);
+size_t ColGridImageSize(const ColGrid* grid);
+void ColGridWriteImage(const ColGrid* grid, ColGridImage* image);
+void ColGridFree(ColGrid* grid);
+size_t ColGridQuery(ColGrid* grid, long minX, long minZ, long maxX, long maxZ, unsigned short* results, size_t maxResults);
+
+#endif
@@ -1,34 +1,290 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
 #include "graphics.h"
+#include "profiler.h"
+#include "vram.h"
+
+#define TPAGEPOSITIONMASK 0x81f // getTPage() bits that come from its x and y
 
 DB db[2] = { 0 };
 DB* cdb = 0;
-DR_MODE* drModeList = 0;
 //DR_MODE resetDRMODE;
 //RECT resetRect = { 0, 0, 0, 0 };
-u_char curdrModeIndex = 0;
-u_char curTPage = 0;
-
-MATRIX globalRenderTransform = { 0 };
 
 TIM_IMAGE woodPanel_tim;
 TIM_IMAGE woodDoor_tim;
 TIM_IMAGE cobble_tim;
 
-void LoadTexture(u_long* tim, TIM_IMAGE* tparam) {     // This part is from Lameguy64's tutorial series : lameguy64.net/svn/pstutorials/chapter1/3-textures.html login/pw: annoyingmous
+TIM_IMAGE* textureTable[TEX_Count] = { &woodPanel_tim, &woodDoor_tim, &cobble_tim };
+TexturePlacement texturePlacements[TEX_Count];
+
+// Transfer into VRAM that hasn't been handed to the GPU yet
+typedef struct Upload {
+    RECT rect;
+    u_long* data;
+} Upload;
+
+// Ring buffer, oldest first
+static Upload uploads[UPLOADQUEUESIZE];
+static size_t uploadHead = 0;
+static size_t uploadCount = 0;
+
+#if PIPELINEDFRAMES
+// Buffer that is finished on the CPU side and waits for the next VBLANK to be displayed and drawn
+static DB* volatile queuedBuffer = NULL;
+
+// Runs on every VBLANK. Shows the previously drawn buffer and kicks off drawing of the queued one,
+// so the main loop never has to wait for VBLANK itself
+// Debug text isn't flushed here, the main loop is already printing the next frame's by the time this runs
+static void FlipCallback() {
+    DB* qdb = queuedBuffer;
+
+    if (qdb == NULL) {
+        return;
+    }
+
+    PutDispEnv(&qdb->disp);
+    PutDrawEnv(&qdb->draw);
+    DrawOTag(&qdb->backgroundOt[OTLAYERSIZE - 1]);
+
+    queuedBuffer = NULL;
+}
+#endif
+
+// Texel column VRAM word x is at inside its texture page, for a TIM of the given mode
+static short PageTexelX(short x, u_long mode) {
+    short texelsPerWordShift = ((mode & 0x3) < 2) ? 2 - (mode & 0x3) : 0;
+
+    return (x % VRAMPAGEWIDTH) << texelsPerWordShift;
+}
+
+void LoadTexture(u_long* tim, enum TextureID id) {  // This part is from Lameguy64's tutorial series : lameguy64.net/svn/pstutorials/chapter1/3-textures.html login/pw: annoyingmous
+    TIM_IMAGE* tparam = textureTable[id];
+    TexturePlacement* placement = &texturePlacements[id];
+
     OpenTIM(tim);                                   // Open the tim binary data, feed it the address of the data in memory
     ReadTIM(tparam);                                // This read the header of the TIM data and sets the corresponding members of the TIM_IMAGE structure
-    
-    LoadImage(tparam->prect, tparam->paddr);        // Transfer the data from memory to VRAM at position prect.x, prect.y
-    DrawSync(0);                                    // Wait for the drawing to end
-    
+
+    // The rects ReadTIM() points to are part of the file, so the placement keeps its own copies to move around
+    placement->pixels = *tparam->prect;
+
+    if (!VramAllocImage(&placement->pixels)) {
+        printf("VRAM: no room for texture %d, left at %d, %d\n", id, placement->pixels.x, placement->pixels.y);
+    }
+
+    placement->du = PageTexelX(placement->pixels.x, tparam->mode) - PageTexelX(tparam->prect->x, tparam->mode);
+    placement->dv = (placement->pixels.y % VRAMPAGEHEIGHT) - (tparam->prect->y % VRAMPAGEHEIGHT);
+    placement->tpage = getTPage(0, 0, placement->pixels.x, placement->pixels.y);
+    tparam->prect = &placement->pixels;
+
+    QueueUpload(tparam->prect, tparam->paddr);      // Transfer the data from memory to VRAM at position prect.x, prect.y, see FlushUploads()
+
     if (tparam->mode & 0x8) { // check 4th bit       // If 4th bit == 1, TIM has a CLUT
-        LoadImage(tparam->crect, tparam->caddr);    // Load it to VRAM at position crect.x, crect.y
-        DrawSync(0);                                // Wait for drawing to end
+        placement->clut = *tparam->crect;
+
+        if (!VramAllocClut(&placement->clut)) {
+            printf("VRAM: no room for CLUT of texture %d, left at %d, %d\n", id, placement->clut.x, placement->clut.y);
+        }
+
+        placement->clutId = getClut(placement->clut.x, placement->clut.y);
+        tparam->crect = &placement->clut;
+
+        QueueUpload(tparam->crect, tparam->caddr);  // Load it to VRAM at position crect.x, crect.y
     }
 }
 
+// Moves a primitive baked against the TIM position of texture id over to where LoadTexture() put it
+void RelocateTexturedPrim(POLY_FT4* poly, enum TextureID id) {
+    const TexturePlacement* placement = &texturePlacements[id];
+
+    poly->tpage = (poly->tpage & ~TPAGEPOSITIONMASK) | placement->tpage;
+
+    if (textureTable[id]->mode & 0x8) {
+        poly->clut = placement->clutId;
+    }
+
+    poly->u0 += placement->du;
+    poly->u1 += placement->du;
+    poly->u2 += placement->du;
+    poly->u3 += placement->du;
+    poly->v0 += placement->dv;
+    poly->v1 += placement->dv;
+    poly->v2 += placement->dv;
+    poly->v3 += placement->dv;
+}
+
+// Points poly at a u, v, uvwidth x uvheight rect of a texture where LoadTexture() put it, the same way
+// the level compiler sets up templates with setUVWH() before RelocateTexturedPrim() moves them
+void SetTexturedPrim(POLY_FT4* poly, enum TextureID id, u_char u, u_char v, u_char uvwidth, u_char uvheight) {
+    const TexturePlacement* placement = &texturePlacements[id];
+
+    poly->tpage = getTPage(textureTable[id]->mode & 0x3, 0, placement->pixels.x, placement->pixels.y);
+    poly->clut = (textureTable[id]->mode & 0x8) ? placement->clutId : 0;
+    setUVWH(poly, u + placement->du, v + placement->dv, uvwidth, uvheight);
+}
+
+// Hands queued transfers to the GPU, oldest first, until the next one would go over budget bytes
+// The first one always goes however big it is, so nothing gets stuck. Doesn't wait for any of them to finish
+static void SubmitUploads(u_long budget) {
+    u_long submitted = 0;
+
+    while (uploadCount > 0) {
+        Upload* upload = &uploads[uploadHead];
+        u_long bytes = upload->rect.w * upload->rect.h * 2;
+
+        if (submitted > 0 && submitted + bytes > budget) {
+            break;
+        }
+
+        LoadImage(&upload->rect, upload->data);
+        submitted += bytes;
+
+        uploadHead = (uploadHead + 1) % UPLOADQUEUESIZE;
+        uploadCount--;
+    }
+}
+
+// Queues a transfer of data to rect in VRAM. data has to stay around until it's done
+// Queued transfers go out in FlushUploads(), or a few per frame from DrawFrame() ahead of the frame's drawing
+void QueueUpload(const RECT* rect, u_long* data) {
+    if (uploadCount == UPLOADQUEUESIZE) {
+        FlushUploads();
+    }
+
+    Upload* upload = &uploads[(uploadHead + uploadCount) % UPLOADQUEUESIZE];
+    upload->rect = *rect;
+    upload->data = data;
+    uploadCount++;
+}
+
+// Sends every queued transfer back to back and waits for all of them at once
+void FlushUploads() {
+    SubmitUploads((u_long)-1);
+    DrawSync(0);
+}
+
+// Resets the current buffer for a new frame. Must only be called once the GPU is done with it
+static void BeginBuffer() {
+    // Initialises a linked list for OT / clears (zeroes?) OT for current frame in reverse order (faster)
+    // "When an OT is initialized, the polygons are unlinked, and only then is a re-sort possible. 
+    // Therefore, it is always necessary to initialize an OT prior to executing a sort." - Library Overview, 10-8
+    ClearOTagR(cdb->backgroundOt, OTLAYERSIZE);
+    ClearOTagR(cdb->ot, OTSIZE);
+    ClearOTagR(cdb->foregroundOt, OTLAYERSIZE);
+
+    // The end of each layer leads into the far end of the next one, so a single DrawOTag() goes through all of them
+    // Primitives added at entry 0 are put in between, ahead of the link
+    catPrim(&cdb->backgroundOt[0], &cdb->ot[OTSIZE - 1]);
+    catPrim(&cdb->ot[0], &cdb->foregroundOt[OTLAYERSIZE - 1]);
+
+    cdb->nextPrim = cdb->primBuffer;
+    cdb->drModeCount = 0;
+}
+
+// Returns the entry of the current buffer's layer a primitive at GTE average depth otz goes into
+// Returns NULL if otz is behind the camera or past the end of the layer
+u_long* OTEntry(enum OTLayer layer, long otz) {
+    if (otz <= 0) {
+        return NULL;
+    }
+
+    if (layer == OTL_World) {
+        otz >>= OTZSHIFT;
+        return (otz < OTSIZE) ? &cdb->ot[otz] : NULL;
+    }
+
+    otz >>= OTLAYERZSHIFT;
+
+    if (otz >= OTLAYERSIZE) {
+        return NULL;
+    }
+
+    return (layer == OTL_Background) ? &cdb->backgroundOt[otz] : &cdb->foregroundOt[otz];
+}
+
+// Copies a template primitive to the next free spot in the current buffer's arena and returns the copy
+// The spot is only kept once CommitPrim() is called, so culled faces don't use up any space
+// Returns NULL if the arena is full
+void* CopyPrim(const void* templatePrim, size_t size) {
+    if (cdb->nextPrim + size > cdb->primBuffer + PRIMBUFFERSIZE) {
+        return NULL;
+    }
+
+    memcpy(cdb->nextPrim, templatePrim, size);
+    return cdb->nextPrim;
+}
+
+// Keeps the primitive last returned by CopyPrim()
+void CommitPrim(size_t size) {
+    cdb->nextPrim += size;
+}
+
+// Claims count consecutive DR_MODEs of the current buffer
+// Returns NULL once the frame's SPECPRIMSSIZE are used up, callers have to be able to draw without them
+DR_MODE* AllocDrModes(size_t count) {
+    if (cdb->drModeCount + count > SPECPRIMSSIZE) {
+        return NULL;
+    }
+
+    DR_MODE* modes = &cdb->drModes[cdb->drModeCount];
+    cdb->drModeCount += count;
+
+    return modes;
+}
+
+// Flat textured polygons, FT3 and FT4 with or without semi transparency, keep their tpage in the same spot
+static bool HasTPage(void* prim) {
+    return getlen(prim) > 0 && (getcode(prim) & 0xF4) == 0x24;
+}
+
+// Links a flat textured polygon into entry right behind one with the same tpage, if the entry has one, so the GPU
+// switches pages once per group instead of per primitive. Otherwise, or with TPAGESORT off, it goes to the front
+// The search ends at the first DR_MODE, primitives behind it belong to a texture window run
+void AddPrimByTPage(u_long* entry, void* prim) {
+#if TPAGESORT
+    u_short tpage = ((POLY_FT3*)prim)->tpage;
+
+    for (void* p = nextPrim(entry); getlen(p) > 0 && getcode(p) != 0xE1; p = nextPrim(p)) {
+        if (HasTPage(p) && ((POLY_FT3*)p)->tpage == tpage) {
+            AddPrim(p, prim);
+            return;
+        }
+    }
+#endif
+
+    AddPrim(entry, prim);
+}
+
+// Walks the current buffer's OT the way the GPU will and counts how often the texture page changes
+// Touches every primitive of the frame, so it's only meant for the profiler
+u_short CountTPageSwitches() {
+    u_short switches = 0;
+    long lastTPage = -1;
+
+    for (void* p = &cdb->backgroundOt[OTLAYERSIZE - 1]; !isendprim(p); p = nextPrim(p)) {
+        long tpage = -1;
+
+        if (HasTPage(p)) {
+            tpage = ((POLY_FT3*)p)->tpage;
+        }
+        else if (getlen(p) > 0 && getcode(p) == 0xE1) {
+            tpage = ((DR_MODE*)p)->code[0] & 0x9ff;
+        }
+
+        if (tpage != -1 && tpage != lastTPage) {
+            switches++;
+            lastTPage = tpage;
+        }
+    }
+
+    return switches;
+}
+
 void InitGraphics() {
     RECT clearRect;
+    RECT fontRect;
 
     SetDispMask(0);
 
@@ -88,9 +344,36 @@ void InitGraphics() {
 
     //setDrawMode(&resetDRMODE, 0, 1, 0, &resetRect);
 
-    LoadTexture(woodPanel_start, &woodPanel_tim);
-    LoadTexture(woodDoor_start, &woodDoor_tim);
-    LoadTexture(cobble_start, &cobble_tim);
+    // Textures are packed around the framebuffers and the debug font instead of going where their TIMs say
+    VramInit();
+
+    for (int i = 0; i < 2; i++) {
+        RECT* frame = &db[i].draw.clip;
+        RECT clutArea;
+
+        // The rows under a framebuffer are too short for most images, so they are left to CLUTs
+        VramReserve(frame);
+        setRECT(&clutArea, frame->x, frame->y + frame->h, frame->w, VRAMPAGEHEIGHT - frame->h);
+        VramAddClutArea(&clutArea);
+    }
+
+    // FntLoad()'s 4 bit font and the CLUT under it
+    setRECT(&fontRect, 960, 256, VRAMPAGEWIDTH, 129);
+    VramReserve(&fontRect);
+
+    LoadTexture(woodPanel_start, TEX_WoodPanel);
+    LoadTexture(woodDoor_start, TEX_WoodDoor);
+    LoadTexture(cobble_start, TEX_Cobble);
+    FlushUploads();
+
+    printf("VRAM: %lu bytes free\n", VramFreeBytes());
+
+    cdb = &db[0];
+    BeginBuffer();
+
+#if PIPELINEDFRAMES
+    VSyncCallback(FlipCallback);
+#endif
 }
 
 void DrawFrame() {
@@ -122,19 +405,57 @@ void DrawFrame() {
     //FntPrint("HDif: %d\n", heightDif);
     //FntPrint("Space: %d\n", occupiesSameSpace);
 
+#if PIPELINEDFRAMES
+    // This is the only sync point of the frame. The previous buffer has to be kicked off by FlipCallback()
+    // and finished by the GPU before its OT and primitive arena can be reused below
+    ProfilerBegin(PRS_VBlank);
+    // VSync(-1) only reads the VBLANK counter, it's polled here so the headless host build can advance time
+    while (queuedBuffer != NULL) {
+        VSync(-1);
+    }
+
+    ProfilerEnd(PRS_VBlank);
+
+    ProfilerBegin(PRS_DrawSync);
+    DrawSync(0);
+    ProfilerEnd(PRS_DrawSync);
+
+    // The GPU is idle here, so streamed textures go out now and are done before FlipCallback() draws the buffer below
+    SubmitUploads(UPLOADFRAMEBYTES);
+
+    // Draw debug text set in SetDumpFnt with value -1. FlipCallback() is idle until queuedBuffer is set,
+    // so this frame's text is all there and goes onto the buffer the GPU just finished, shown at the next VBLANK
+    FntFlush(-1);
+    queuedBuffer = cdb;
+
+    // Swap used buffer. The CPU builds the next frame into it while the GPU draws the queued one
+    cdb = (cdb == &db[0]) ? &db[1] : &db[0];
+    BeginBuffer();
+#else
     // Wait for previous frame to have finished drawing if needed
+    ProfilerBegin(PRS_DrawSync);
     DrawSync(0);
+    ProfilerEnd(PRS_DrawSync);
 
     // Waits for VBLANK (param = 0 -> waits for generated vertical sync)
+    ProfilerBegin(PRS_VBlank);
     VSync(0);
+    ProfilerEnd(PRS_VBlank);
 
     PutDispEnv(&cdb->disp);
     PutDrawEnv(&cdb->draw);
 
+    // Streamed textures are queued up ahead of the frame's drawing, the GPU goes through both in order
+    SubmitUploads(UPLOADFRAMEBYTES);
+
     // Draw from ordering table
-    DrawOTag(&cdb->ot[OTSIZE - 1]);
-    curdrModeIndex = 0;
+    DrawOTag(&cdb->backgroundOt[OTLAYERSIZE - 1]);
+
+    // Swap used buffer. The other buffer's OT and primitives were finished by the GPU before the DrawSync above
+    cdb = (cdb == &db[0]) ? &db[1] : &db[0];
+    BeginBuffer();
     
     // Draw debug text set in SetDumpFnt with value -1
     FntFlush(-1);
+#endif
 }
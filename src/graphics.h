@@ -1,6 +1,7 @@
 #ifndef __GRAPHICS_H
 #define __GRAPHICS_H
 
+#include <stddef.h>
 #include <libgte.h>
 #include <libetc.h>
 #include <libgpu.h>
@@ -18,11 +19,33 @@ typedef struct {
 } TIM_IMAGE;
 */
 
-#define OTSIZE 2048
-#define SPECPRIMSSIZE 256
+// Ordering tables are split into layers, drawn back to front, that each sort their own primitives by depth
+// Primitives are filed at their GTE average depth (camera space Z / 4) shifted down by the layer's shift,
+// so every layer covers OTDRAWDISTANCE no matter how many entries it has
+#define OTSIZE 1024       // World layer entries
+#define OTZSHIFT 1
+#define OTLAYERSIZE 256   // Background and foreground layer entries
+#define OTLAYERZSHIFT 3
+#define OTDRAWDISTANCE (OTSIZE << (OTZSHIFT + 2)) // Camera space depth at which the world layer runs out
+#define SPECPRIMSSIZE 64 // DR_MODEs each buffer has for a frame, see AllocDrModes()
+#define PRIMBUFFERSIZE 16384 // Bytes per buffer, enough for ~400 POLY_FT4
+#define UPLOADQUEUESIZE 16     // VRAM transfers waiting to go out, see QueueUpload()
+#define UPLOADFRAMEBYTES 16384 // Most bytes of them DrawFrame() starts per frame, the rest waits for the next one
 #define RENDERX 320 // 512
 #define RENDERY 240
 
+// 1 = textured primitives join one with the same tpage in their OT entry if there is one, see AddPrimByTPage()
+// 0 = every primitive goes to the front of its entry
+#ifndef TPAGESORT
+#define TPAGESORT 1
+#endif
+
+// 1 = build the next frame while the GPU draws the current one, flipping buffers in the VSync callback
+// 0 = fully serialised frames (DrawSync + VSync every frame, then draw)
+#ifndef PIPELINEDFRAMES
+#define PIPELINEDFRAMES 1
+#endif
+
 extern u_long woodPanel_start[];
 extern u_long woodPanel_end[];
 extern u_long woodDoor_start[];
@@ -34,25 +57,68 @@ extern TIM_IMAGE woodPanel_tim;
 extern TIM_IMAGE woodDoor_tim;
 extern TIM_IMAGE cobble_tim;
 
+// Textures as referenced by level files
+enum TextureID {
+    TEX_WoodPanel,
+    TEX_WoodDoor,
+    TEX_Cobble,
+    TEX_Count
+};
+
+extern TIM_IMAGE* textureTable[TEX_Count];
+
+// Where LoadTexture() put a texture, the TIM's own position is only a suggestion
+// Level files are baked against the TIM positions, RelocateTexturedPrim() moves their primitives over
+typedef struct TexturePlacement {
+    RECT pixels;    // textureTable[]'s prect and crect point here
+    RECT clut;
+    u_short tpage;  // As getTPage() gives it for the new position, with tp and abr 0
+    u_short clutId;
+    short du;       // Texels the image moved by inside its texture page
+    short dv;
+} TexturePlacement;
+
+extern TexturePlacement texturePlacements[TEX_Count];
+
+enum OTLayer {
+    OTL_Background, // Under everything else, e.g. floors
+    OTL_World,
+    OTL_Foreground, // Over everything else
+    OTL_Count
+};
+
 // (Double) Buffer struct
+// Every primitive linked into ot is copied into primBuffer first, so the CPU never touches what the GPU may still be reading
 typedef struct DB {
     DRAWENV draw;
     DISPENV disp;
+    u_long backgroundOt[OTLAYERSIZE];
     u_long ot[OTSIZE];
+    u_long foregroundOt[OTLAYERSIZE];
+    char primBuffer[PRIMBUFFERSIZE]; // Per-frame primitive arena, right after the OTs so it stays word aligned
+    char* nextPrim;   // Bump pointer into primBuffer, reset whenever this buffer starts a new frame
+    DR_MODE drModes[SPECPRIMSSIZE]; // Texture window changes, kept per buffer like the primitives they go with
+    u_short drModeCount;
 } DB;
 
 extern DB db[2];
 extern DB* cdb;
-extern DR_MODE* drModeList;
 //extern DR_MODE resetDRMODE;
 //extern RECT resetRect;
-extern u_char curdrModeIndex;
-extern u_char curTPage;
 
-extern MATRIX globalRenderTransform;
-
-void LoadTexture(u_long* tim, TIM_IMAGE* tparam);
+void LoadTexture(u_long* tim, enum TextureID id);
+void RelocateTexturedPrim(POLY_FT4* poly, enum TextureID id);
+void SetTexturedPrim(POLY_FT4* poly, enum TextureID id, u_char u, u_char v, u_char uvwidth, u_char uvheight);
+void QueueUpload(const RECT* rect, u_long* data);
+void FlushUploads();
 void InitGraphics();
 void DrawFrame();
 
+u_long* OTEntry(enum OTLayer layer, long otz);
+void* CopyPrim(const void* templatePrim, size_t size);
+void CommitPrim(size_t size);
+DR_MODE* AllocDrModes(size_t count);
+void AddPrimByTPage(u_long* entry, void* prim);
+u_short CountTPageSwitches();
+
 #endif
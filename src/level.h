@@ -0,0 +1,174 @@
+#ifndef __LEVEL_H
+#define __LEVEL_H
+
+#include <sys/types.h>
+
+// Binary level format, written by the level compiler (tools/levelc.c) from a text scene description
+// Levels are embedded like the TIMs (see the Makefile objcopy rules) and used in place wherever possible
+// Everything is little endian and 4-byte aligned, and all offsets are in bytes from the start of the file
+// Kept free of PsyQ types so the level compiler can share it
+
+#define LEVELMAGIC 0x304c564c // "LVL0" in little endian
+#define LEVELVERSION 6
+#define LEVELNOTEXTURE 0xFF // Material is a flat colour
+#define LEVELNOCELL 0xFF    // Object isn't tied to a cell and is drawn from anywhere, e.g. walls between inside and out
+#define LEVELOUTSIDE 0xFE   // The space no cell covers, for objects and portal sides
+
+#define TILEDSEGMENTLENGTH 64 // Distance along X between the faces of a tiled object
+#define MULTIPOLYMAXLATTICE 256 // Most lattice vertices a multi poly can have, the draw path caches them all per frame
+
+extern u_long testlevel_start[];
+extern u_long testlevel_end[];
+
+enum LevelObjectType {
+    LOT_PolyF4,    // PolyObject, polyLength F4 templates
+    LOT_PolyFT4,   // TexturedPolyObject, polyLength FT4 templates
+    LOT_TiledFT4,  // TexturedPolyObject tiled polyLength times along X
+    LOT_MultiPoly, // TestTileMultiPoly, polyLength is the repeats. See the lattice notes below
+    LOT_ColBox,    // StaticCollisionPolyBox, 8 vertices and 6 faces, each drawn from the template of its material
+    LOT_Count
+};
+
+enum LevelObjectFlags {
+    LOF_Static = 1,
+    LOF_Collides = 2,
+    LOF_Repeating = 4,       // Textured objects only
+    LOF_ReverseOrder = 8,    // Multi polys only
+    LOF_AutoRotate = 16,     // Spun by the main loop while auto rotation is on
+    LOF_BatchTransform = 32, // Drawn through the batch transform path, PolyF4, PolyFT4 and ColBox only
+    LOF_Subdivide = 64       // Faces are split when near the camera and clipped against the near plane, PolyFT4 only
+};
+
+// Multi polys store a lattice of (polyLength * subdivs + 1) columns by (subdivs + 1) rows, row by row
+// Columns step along X, rows step up for walls (height != 0) or along Z for floors (height == 0)
+// Their 4 indices are the lattice offsets of a face's corners from the face's lowest lattice vertex, in drawing order
+// The FT4 templates go through the faces top row first, each row from X = 0
+
+typedef struct LevelHeader {
+    u_int magic;
+    u_short version;
+    u_short vertexCount;
+    u_short indexCount;
+    u_short materialCount;
+    u_short objectCounts[LOT_Count];
+    u_short polyF4Count;
+    u_short polyFT4Count;
+    u_short lodCount;
+    u_short cellCount;
+    u_short portalCount;
+    u_short faceCount;
+    u_short pad;
+    u_int vertexOffset;   // SVECTOR[vertexCount]
+    u_int indexOffset;    // u_int[indexCount], relative to the object's firstVertex
+    u_int materialOffset; // LevelMaterial[materialCount]
+    u_int objectOffset;   // LevelObject[sum of objectCounts]
+    u_int polyF4Offset;   // LevelPolyF4[polyF4Count]
+    u_int polyFT4Offset;  // LevelPolyFT4[polyFT4Count]
+    u_int gridOffset;     // ColGridImage over the level's collision boxes, 0 if there is none
+    u_int lodOffset;      // LevelLod[lodCount], in the order of the objects they belong to
+    u_int cellOffset;     // LevelCell[cellCount]
+    u_int portalOffset;   // LevelPortal[portalCount]
+    u_int faceOffset;     // u_short[faceCount], the material of every colbox face
+} LevelHeader;
+
+typedef struct LevelMaterial {
+    u_char texture; // TextureID, or LEVELNOTEXTURE
+    u_char r;
+    u_char g;
+    u_char b;
+
+    u_char u0;
+    u_char v0;
+    u_char uvwidth;
+    u_char uvheight;
+
+    u_char twx; // Texture window, used by repeating objects
+    u_char twy;
+    u_char tww;
+    u_char twh;
+} LevelMaterial;
+
+typedef struct LevelObject {
+    u_char type;  // LevelObjectType
+    u_char flags; // LevelObjectFlags
+    u_char drPrio;
+    u_char polySides;
+
+    u_short polyLength; // Faces, or repeats for multi polys
+    u_short firstMaterial;
+    u_short firstVertex;
+    u_short firstIndex;
+    u_short firstPoly; // Into the F4 or FT4 templates, depending on type. Into the faces for colboxes
+    u_short boundsRadius;
+
+    short position[3];
+    short rotation[3];
+    short boundsCentre[3]; // Local space, fitted by the level compiler
+    u_char lodCount;       // LevelLods following the ones of the objects before it. PolyF4, PolyFT4 and ColBox only
+    u_char cell;           // Index into the cells, LEVELOUTSIDE or LEVELNOCELL. Static objects and colboxes only
+
+    u_short boxHeight; // Collision size of PolyObjects
+    u_short boxWidth;
+
+    u_char subdivs; // Multi polys only
+    u_char width;
+    u_char height;
+    u_char depth;
+} LevelObject;
+
+// Cheaper mesh an object switches to from a camera distance on. An object's LODs go from near to far
+// Flat LODs are drawn from F4 templates without a texture, and are the only kind PolyF4 objects and colboxes can have
+// Colboxes always keep their own 8 corners and 6 faces
+typedef struct LevelLod {
+    u_short distance; // Camera space depth
+    u_short polyLength;
+    u_short firstVertex;
+    u_short firstIndex;
+    u_short firstPoly; // Into the F4 templates if flat, the FT4 ones otherwise
+    u_char flat;
+    u_char pad;
+} LevelLod;
+
+// Box of space, usually a room, that's only drawn while the camera is in it or sees it through a portal
+// Objects list the cell they are in. Cells shouldn't overlap, the camera is in the first one containing it
+typedef struct LevelCell {
+    short mins[3];
+    short maxs[3];
+} LevelCell;
+
+// Opening between two cells (or a cell and LEVELOUTSIDE), e.g. a doorway. Its 4 corners are in world space,
+// in order around its edge, and it can be seen through from both sides
+typedef struct LevelPortal {
+    short corners[4][3];
+    u_char cells[2];
+    u_short pad;
+} LevelPortal;
+
+// Primitive templates in the console's layout, with tpage, clut and UVs already resolved. The console uses them in place
+typedef struct LevelPolyF4 {
+    u_int tag;
+    u_char r0, g0, b0, code;
+    short x0, y0;
+    short x1, y1;
+    short x2, y2;
+    short x3, y3;
+} LevelPolyF4;
+
+typedef struct LevelPolyFT4 {
+    u_int tag;
+    u_char r0, g0, b0, code;
+    short x0, y0;
+    u_char u0, v0;
+    u_short clut;
+    short x1, y1;
+    u_char u1, v1;
+    u_short tpage;
+    short x2, y2;
+    u_char u2, v2;
+    u_short pad1;
+    short x3, y3;
+    u_char u3, v3;
+    u_short pad2;
+} LevelPolyFT4;
+
+#endif
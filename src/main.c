@@ -1,5 +1,7 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <libgte.h>
 #include <libetc.h>
 #include <libgpu.h>
@@ -9,42 +11,85 @@
 
 #include "graphics.h"
 #include "objects.h"
+#include "level.h"
+#include "colgrid.h"
+#include "cells.h"
+#include "pool.h"
+#include "profiler.h"
+#include "replay.h"
+#include "scratchpad.h"
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof(*(a)))
 #define setPosVToGrid(v, _x, _y, _z) \
 	(v)->vx = _x >> 12, (v)->vy = _y >> 12, (v)->vz = _z >> 12
+#define SXYX(sxy) ((short)(sxy))         // Screen X of a packed GTE SXY value
+#define SXYY(sxy) ((short)((sxy) >> 16)) // Screen Y of a packed GTE SXY value
+// Corners in face order, the primitive's 3rd and 4th vertex are swapped like in the RotAverageNclip4() calls
+#define setCachedXY4(p, c0, c1, c2, c3) \
+    setXY4(p, SXYX(meshSXY[c0]), SXYY(meshSXY[c0]), SXYX(meshSXY[c1]), SXYY(meshSXY[c1]), \
+        SXYX(meshSXY[c3]), SXYY(meshSXY[c3]), SXYX(meshSXY[c2]), SXYY(meshSXY[c2]))
+
+// Headless host builds run a fixed number of frames and then report, see host/psxshim.c
+#ifdef HOST
+#define KEEPRUNNING() HostFrameContinue()
+#else
+#define KEEPRUNNING() 1
+#endif
 
 #define SCREENXRES 640
 #define SCREENYRES 480
 #define FOV SCREENXRES / 2
-#define DISTTHING 512
 
 #define PLAYERHEIGHT 48
 #define PLAYERWIDTHHALF 20
 #define CAMERADISTANCE 160 // 160
 
-#define CUBESIZE 80
-#define CUBEHALF CUBESIZE / 2
-#define FLOORSIZE 128
-#define FLOORHALF FLOORSIZE / 2
-#define LONGFLOORLENGTH 320
-#define LONGFLOORHALF LONGFLOORLENGTH / 2
-#define COLBOXHEIGHT 12
-#define COLBOXHALFWIDTH 32
-
-#define WALLHEIGHT 128
-#define WALLHALF 64
-#define DOORHALF 32
-
 #define ANALOGUE_MID 127
 #define ANALOGUE_DEADZONE 24
 #define ANALOGUE_MINPOS ANALOGUE_MID + ANALOGUE_DEADZONE
 #define ANALOGUE_MINNEG ANALOGUE_MID - ANALOGUE_DEADZONE
 
-#define ACTIVEPOLYGONCOUNT 3
-#define ACTIVETEXPOLYGONCOUNT 5
-#define ACTIVETILEDTEXPOLYGONCOUNT 1
-#define ACTIVECOLBOXCOUNT 6
+// Objects whose bounding sphere is entirely outside of these camera space depths are culled
+// Anything further than OTDRAWDISTANCE would be dropped by the OT range check anyway
+#define CULLNEARDISTANCE 1
+#define CULLFARDISTANCE OTDRAWDISTANCE
+
+// The GTE's perspective divide saturates nearer than half the projection distance (RENDERX / 2, see InitGraphics())
+// Subdivided faces are clipped against this depth, with a little slack for rounding, so every corner they draw with is projected properly
+#define NEARCLIPDISTANCE ((RENDERX / 4) + 4)
+// Subdivided faces with a corner nearer than these depths are split 4x4 or 2x2, anything further is drawn whole
+#define SUBDIVIDE4DISTANCE 256
+#define SUBDIVIDE2DISTANCE 512
+#define MAXSUBDIVS 4
+// Objects only switch LOD once they are this far past the switch distance, so they don't flicker right at it
+#define LODHYSTERESIS 128
+
+// Most objects of each kind a level can hold
+#define MAXPOLYGONS 16
+#define MAXTEXPOLYGONS 32
+#define MAXTILEDTEXPOLYGONS 8
+#define MAXMULTIPOLYS 8
+#define MAXCOLBOXES 64
+#define MAXMATERIALPRIMS 64 // Materials of every loaded level together, colbox faces index them with a u_char
+#define MAXSTATICCHUNKS 32
+#define MAXCHUNKMEMBERS (MAXPOLYGONS + MAXTEXPOLYGONS + MAXMULTIPOLYS + MAXCOLBOXES)
+#define CHUNKCELLSHIFT 9 // Static chunks are cut along a grid of 512x512 cells on X and Z
+#define LEVELALIGN(size) (((size) + 7) & ~7) // Blocks of the level arena are kept 8-byte aligned
+#define LEVELARENASIZE 0x8000 // Bytes for everything the loaded levels need besides their objects, see TakeLevelMemory()
+#define COLQUERYMAX MAXCOLBOXES // Every active box fits, so a player query is never cut short however crowded its cells are
+#define MESHCACHESIZE MULTIPOLYMAXLATTICE // Most vertices a batch transformed mesh can have
+// Most vertices the scratchpad screen cache holds, bigger meshes use the main RAM one
+// The host's longs are twice as wide, so it holds half as many to fit the same 1 KB
+#ifdef HOST
+#define SCRATCHMESHSIZE 48
+#else
+#define SCRATCHMESHSIZE 96
+#endif
+
+#define PLAYERMAXFALLSPEED (24 * ONE)
+#define PLAYERSTEPHEIGHT 32
+#define MAXSWEEPSPEED (64 * ONE) // Keeps (distance * ONE) inside 32 bits in the time of impact division
+#define SWEEPITERATIONS 3        // One slide per axis at most
 
 
 typedef struct Vector2UB {
@@ -63,13 +108,6 @@ typedef struct GamePad {
 } GamePad;
 
 
-static SVECTOR colBoxVertices[] = {
-    { -COLBOXHALFWIDTH, -COLBOXHEIGHT, -COLBOXHALFWIDTH, 0 }, {  COLBOXHALFWIDTH, -COLBOXHEIGHT, -COLBOXHALFWIDTH, 0 },
-    {  COLBOXHALFWIDTH,  0,            -COLBOXHALFWIDTH, 0 }, { -COLBOXHALFWIDTH,  0,            -COLBOXHALFWIDTH, 0 },
-    { -COLBOXHALFWIDTH, -COLBOXHEIGHT,  COLBOXHALFWIDTH, 0 }, {  COLBOXHALFWIDTH, -COLBOXHEIGHT,  COLBOXHALFWIDTH, 0 },
-    {  COLBOXHALFWIDTH,  0,             COLBOXHALFWIDTH, 0 }, { -COLBOXHALFWIDTH,  0,             COLBOXHALFWIDTH, 0 },
-};
-
 static SVECTOR playerBoxVertices[] = {
     { -PLAYERWIDTHHALF, -PLAYERHEIGHT, -PLAYERWIDTHHALF, 0 }, {  PLAYERWIDTHHALF, -PLAYERHEIGHT, -PLAYERWIDTHHALF, 0 },
     {  PLAYERWIDTHHALF, 0, -PLAYERWIDTHHALF, 0 }, { -PLAYERWIDTHHALF, 0, -PLAYERWIDTHHALF, 0 },
@@ -77,71 +115,6 @@ static SVECTOR playerBoxVertices[] = {
     {  PLAYERWIDTHHALF, 0,  PLAYERWIDTHHALF, 0 }, { -PLAYERWIDTHHALF, 0,  PLAYERWIDTHHALF, 0 },
 };
 
-static SVECTOR cubeVertices[] = {
-    { -CUBEHALF, -CUBEHALF, -CUBEHALF, 0 }, { CUBEHALF , -CUBEHALF, -CUBEHALF, 0 },
-    { CUBEHALF , CUBEHALF , -CUBEHALF, 0 }, { -CUBEHALF, CUBEHALF , -CUBEHALF, 0 },
-    { -CUBEHALF, -CUBEHALF, CUBEHALF , 0 }, { CUBEHALF , -CUBEHALF, CUBEHALF , 0 },
-    { CUBEHALF , CUBEHALF , CUBEHALF , 0 }, { -CUBEHALF, CUBEHALF , CUBEHALF , 0 }
-};
-
-static SVECTOR tinyHouseVertices[] = {
-    { 0, -WALLHEIGHT, 0, 0 },               { WALLHALF, -WALLHEIGHT, 0, 0 },
-    { WALLHALF,  0,  0, 0 },                { 0,  0,          0, 0 },
-    { 0, -WALLHEIGHT,  WALLHALF * 2, 0 },   { WALLHALF, -WALLHEIGHT,  WALLHALF * 2, 0 },
-    { WALLHALF,  0,  WALLHALF * 2, 0 },     { 0,  0,           WALLHALF * 2, 0 },
-};
-
-static SVECTOR tinyBoxVertices[] = {
-    { 0, -DOORHALF, 0, 0 },               { DOORHALF, -DOORHALF, 0, 0 },
-    { DOORHALF,  0,  0, 0 },                { 0,  0,          0, 0 },
-    { 0, -DOORHALF,  DOORHALF, 0 },   { DOORHALF, -DOORHALF,  DOORHALF, 0 },
-    { DOORHALF,  0,  DOORHALF, 0 },     { 0,  0,           DOORHALF, 0 },
-};
-
-static SVECTOR boxVertices[] = {
-    { 0, -WALLHALF, 0, 0 },               { WALLHALF, -WALLHALF, 0, 0 },
-    { WALLHALF,  0,  0, 0 },                { 0,  0,          0, 0 },
-    { 0, -WALLHALF,  WALLHALF, 0 },   { WALLHALF, -WALLHALF,  WALLHALF, 0 },
-    { WALLHALF,  0,  WALLHALF, 0 },     { 0,  0,           WALLHALF, 0 },
-};
-
-static SVECTOR platformVertices[] = {
-    { 0, -16, 0, 0 }, { WALLHALF, -16, 0, 0 },
-    { WALLHALF, 0,  0, 0 }, { 0, 0, 0, 0 },
-    { 0, -16,  WALLHALF, 0 }, { WALLHALF, -16,  WALLHALF, 0 },
-    { WALLHALF, 0,  WALLHALF, 0 }, { 0, 0, WALLHALF, 0 },
-};
-
-/*
-static SVECTOR tWallVertices[] = {
-    { -WALLHALF, -WALLHEIGHT, -DOORHALF, 0 }, {  WALLHALF, -WALLHEIGHT, -DOORHALF, 0 },
-    {  WALLHALF,  0,          -DOORHALF, 0 }, { -WALLHALF,  0,          -DOORHALF, 0 },
-    { -WALLHALF, -WALLHEIGHT,  DOORHALF, 0 }, {  WALLHALF, -WALLHEIGHT,  DOORHALF, 0 },
-    {  WALLHALF,  0,           DOORHALF, 0 }, { -WALLHALF,  0,           DOORHALF, 0 },
-};
-
-static SVECTOR tDoorVertices[] = {
-    { -DOORHALF, -WALLHEIGHT, -DOORHALF, 0 }, {  DOORHALF, -WALLHEIGHT, -DOORHALF, 0 },
-    {  DOORHALF,  0,          -DOORHALF, 0 }, { -DOORHALF,  0,          -DOORHALF, 0 },
-    { -DOORHALF, -WALLHEIGHT,  DOORHALF, 0 }, {  DOORHALF, -WALLHEIGHT,  DOORHALF, 0 },
-    {  DOORHALF,  0,           DOORHALF, 0 }, { -DOORHALF,  0,           DOORHALF, 0 },
-};
-*/
-
-static SVECTOR tWallVertices[] = {
-    { 0, -WALLHEIGHT, 0, 0 },               { WALLHALF * 2, -WALLHEIGHT, 0, 0 },
-    { WALLHALF * 2,  0,  0, 0 },    { 0,  0,          0, 0 },
-    { 0, -WALLHEIGHT,  WALLHALF, 0 },       { WALLHALF * 2, -WALLHEIGHT,  WALLHALF, 0 },
-    { WALLHALF * 2,  0,  WALLHALF, 0 },     { 0,  0,           WALLHALF, 0 }
-};
-
-static SVECTOR tDoorVertices[] = {
-    { 0, -WALLHEIGHT, 0, 0 }, {  WALLHALF, -WALLHEIGHT, 0, 0 },
-    { WALLHALF,  0,          0, 0 }, { 0,  0,          0, 0 },
-    { 0, -WALLHEIGHT,  WALLHALF, 0 }, {  WALLHALF, -WALLHEIGHT,  WALLHALF, 0 },
-    { WALLHALF,  0,           WALLHALF, 0 }, { 0,  0,           WALLHALF, 0 },
-};
-
 static long cubeIndices[] = {
     0, 1, 2, 3, // Back?
     1, 5, 6, 2, // Right?
@@ -151,46 +124,103 @@ static long cubeIndices[] = {
     6, 7, 3, 2  // Bottom
 };
 
-static long tubeIndices[] = {
-    0, 1, 2, 3, 
-    1, 5, 6, 2, 
-    5, 4, 7, 6, 
-    4, 0, 3, 7
-};
-
-static SVECTOR floorVertices[] = {
-    { -FLOORHALF, 0, -FLOORHALF, 0 }, {  FLOORHALF, 0, -FLOORHALF, 0 },
-    {  FLOORHALF, 0,  FLOORHALF, 0 }, { -FLOORHALF, 0,  FLOORHALF, 0 }
-};
-
-static SVECTOR longFloorVertices[] = {
-    { 0, 0, 0, 0 },                       { LONGFLOORLENGTH, 0, 0, 0 },
-    { LONGFLOORLENGTH, 0, FLOORSIZE, 0 }, { 0, 0, FLOORSIZE, 0 }
-};
 
-static SVECTOR tiledPanelVertices[] = {
-    { 0, -WALLHEIGHT, 0, 0 }, { WALLHALF, -WALLHEIGHT, 0, 0 },
-    { WALLHALF, 0, 0, 0 }, { 0, 0, 0, 0 }
-};
+PlayerObject* player = NULL;
+static PlayerObject playerObject;
+static CameraObject playerCamera;
+static POLY_F4 playerPolys[6];
+bool isPlayerOnFloor = true;
+bool isPlayerOnCollision = false;
 
-static long floorIndices[] = {
-    0, 3, 2, 1
-};
+PolyObject* activePolygons[MAXPOLYGONS];
+TexturedPolyObject* activeTexPolygons[MAXTEXPOLYGONS];
+TexturedPolyObject* activeTiledTexPolygons[MAXTILEDTEXPOLYGONS];
+TestTileMultiPoly* activeMultiPolys[MAXMULTIPOLYS];
+StaticCollisionPolyBox* activeCollisionPolyBoxes[MAXCOLBOXES];
+
+size_t activePolygonCount = 0;
+size_t activeTexPolygonCount = 0;
+size_t activeTiledTexPolygonCount = 0;
+size_t activeMultiPolyCount = 0;
+size_t activeCollisionPolyBoxCount = 0;
+
+// Level objects come out of these, the active lists above point into them
+POOLDEFINE(polyObjectPool, PolyObject, MAXPOLYGONS);
+POOLDEFINE(texObjectPool, TexturedPolyObject, MAXTEXPOLYGONS + MAXTILEDTEXPOLYGONS);
+POOLDEFINE(multiPolyPool, TestTileMultiPoly, MAXMULTIPOLYS);
+POOLDEFINE(colBoxPool, StaticCollisionPolyBox, MAXCOLBOXES);
+
+// LOD levels, collision stamps, chunk vertices and the textured templates of every loaded level, one after another
+// Levels only ever take from the end, UnloadLevels() gives it all back at once
+static u_long levelArena[LEVELARENASIZE / sizeof(u_long)];
+static size_t levelArenaUsed = 0;
+
+StaticChunk staticChunks[MAXSTATICCHUNKS];
+ChunkMember chunkMembers[MAXCHUNKMEMBERS];
+size_t staticChunkCount = 0;
+size_t chunkMemberCount = 0;
+
+ColGrid collisionGrid;
+CellGraph cellGraph;
+
+// One textured template per level material, shared by every colbox face that uses it, see LoadMaterialPrims()
+POLY_FT4 materialPrims[MAXMATERIALPRIMS];
+size_t materialPrimCount = 0;
+
+// OT layer each DrawPriority sorts into. Low priority objects like floors go under the world, high ones over it
+static const enum OTLayer priorityLayers[] = { OTL_World, OTL_Background, OTL_Foreground };
+
+// Screen XY and depth of every vertex of the mesh or multi poly lattice being drawn, see TransformMeshVertices()
+// 2 spare entries for the last RTPT batch
+static long mainMeshSXY[MESHCACHESIZE + 2];
+static long mainMeshSZ[MESHCACHESIZE + 2];
+// Same for meshes of up to SCRATCHMESHSIZE vertices, NULL if the scratchpad had no room
+static long* scratchMeshSXY = NULL;
+static long* scratchMeshSZ = NULL;
+// Whichever of the two the current mesh went into
+static long* meshSXY = mainMeshSXY;
+static long* meshSZ = mainMeshSZ;
+
+// Results of the per-face GTE calls that are thrown away, and the moved corners of a tile
+typedef struct DrawTemps {
+    SVECTOR tileVertices[4];
+    long p;
+    long flg;
+} DrawTemps;
+
+static DrawTemps mainDrawTemps;
+static DrawTemps* drawTemps = &mainDrawTemps;
+
+// Moves the OT building loops' caches and temporaries into the scratchpad, whatever doesn't fit stays in main RAM
+static void InitDrawScratchpad() {
+    DrawTemps* temps = ScratchpadAlloc(sizeof(DrawTemps));
+
+    if (temps != NULL) {
+        drawTemps = temps;
+    }
 
-static long tileWallIndices[] = {
-    0, 1, 2, 3
-};
+    scratchMeshSXY = ScratchpadAlloc(sizeof(long) * (SCRATCHMESHSIZE + 2));
+    scratchMeshSZ = ScratchpadAlloc(sizeof(long) * (SCRATCHMESHSIZE + 2));
 
+    if (scratchMeshSXY == NULL || scratchMeshSZ == NULL) {
+        scratchMeshSXY = NULL;
+        scratchMeshSZ = NULL;
+    }
+}
 
-PlayerObject* player = NULL;
-bool isPlayerOnFloor = true;
-bool isPlayerOnCollision = false;
+// Builds the broadphase grid over every active collision box. Boxes are static, so this only runs once per level
+static void BuildCollisionGrid() {
+    ColGridBounds bounds[MAXCOLBOXES];
 
-PolyObject* activePolygons[ACTIVEPOLYGONCOUNT];
-TexturedPolyObject* activeTexPolygons[ACTIVETEXPOLYGONCOUNT];
-TexturedPolyObject* activeTiledTexPolygons[ACTIVETILEDTEXPOLYGONCOUNT];
+    for (size_t i = 0; i < activeCollisionPolyBoxCount; i++) {
+        bounds[i].minX = activeCollisionPolyBoxes[i]->transform.t[0];
+        bounds[i].minZ = activeCollisionPolyBoxes[i]->transform.t[2];
+        bounds[i].maxX = activeCollisionPolyBoxes[i]->transform.t[0] + activeCollisionPolyBoxes[i]->colBox.dimensions.vx;
+        bounds[i].maxZ = activeCollisionPolyBoxes[i]->transform.t[2] + activeCollisionPolyBoxes[i]->colBox.dimensions.vz;
+    }
 
-StaticCollisionPolyBox* activeCollisionPolyBoxes[ACTIVECOLBOXCOUNT];
+    ColGridBuild(&collisionGrid, bounds, activeCollisionPolyBoxCount);
+}
 
 // overlaps is treated as an out parameter
 void ScanForOverlaps(const VECTOR* pMins, const VECTOR* pMaxs, const StaticCollisionPolyBox* scpolybox, CollisionOverlaps* overlaps) {
@@ -219,18 +249,21 @@ bool CanPlayerStep(const VECTOR* position) {
     VECTOR gridMins = { 
         (position->vx >> 12) - player->poly.boxWidth / 2,
         (position->vy >> 12),
-        (position->vz >> 12) - player->poly.boxWidth / 2
+        (position->vz >> 12) - player->poly.boxWidth / 2, 0
     };
 
     VECTOR gridMaxs = { 
         (position->vx >> 12) + player->poly.boxWidth / 2,
         (position->vy >> 12) - player->poly.boxHeight,
-        (position->vz >> 12) + player->poly.boxWidth / 2
+        (position->vz >> 12) + player->poly.boxWidth / 2, 0
     };
 
-    for (size_t i = 0; i < ACTIVECOLBOXCOUNT; i++) {
+    unsigned short candidates[COLQUERYMAX];
+    size_t candidateCount = ColGridQuery(&collisionGrid, gridMins.vx, gridMins.vz, gridMaxs.vx, gridMaxs.vz, candidates, COLQUERYMAX);
+
+    for (size_t c = 0; c < candidateCount; c++) {
         CollisionOverlaps overlaps = { 0 };
-        ScanForOverlaps(&gridMins, &gridMaxs, activeCollisionPolyBoxes[i], &overlaps);
+        ScanForOverlaps(&gridMins, &gridMaxs, activeCollisionPolyBoxes[candidates[c]], &overlaps);
 
         if (overlaps.x == true && overlaps.y == true && overlaps.z == true) {
             canStep = false;
@@ -241,13 +274,178 @@ bool CanPlayerStep(const VECTOR* position) {
     return canStep;
 }
 
+// Fraction (ONE = whole frame) of a move of vel needed to cover dist. Results outside of [-ONE, ONE] are clamped to +-2 * ONE
+static long SweepTime(long dist, long vel) {
+    if (abs(dist) > abs(vel)) {
+        return ((dist < 0) == (vel < 0)) ? 2 * ONE : -2 * ONE;
+    }
+
+    return (dist * ONE) / vel;
+}
+
+// Swept AABB test of the player moving by move against one box, all in fixed point
+// Returns the time of impact (0 - ONE) and the axis that was hit, or -1 if the box isn't hit during this move
+// Boxes the player already overlaps are left to the overlap resolver in SimulatePlayerMovementCollision()
+static long SweepPlayerAgainstBox(const VECTOR* pMins, const VECTOR* pMaxs, const VECTOR* move, const StaticCollisionPolyBox* scpolybox, int* hitAxis) {
+    // Y grows downwards, so the top of the box is its minimum
+    long bMins[3] = { 
+        scpolybox->position.vx, 
+        scpolybox->position.vy - (scpolybox->colBox.dimensions.vy * ONE), 
+        scpolybox->position.vz 
+    };
+    long bMaxs[3] = { 
+        scpolybox->position.vx + (scpolybox->colBox.dimensions.vx * ONE), 
+        scpolybox->position.vy, 
+        scpolybox->position.vz + (scpolybox->colBox.dimensions.vz * ONE) 
+    };
+    long pMin[3] = { pMins->vx, pMins->vy, pMins->vz };
+    long pMax[3] = { pMaxs->vx, pMaxs->vy, pMaxs->vz };
+    long vel[3] = { move->vx, move->vy, move->vz };
+
+    long entry = -2 * ONE;
+    long exit = 2 * ONE;
+    *hitAxis = -1;
+
+    for (int a = 0; a < 3; a++) {
+        long axisEntry;
+        long axisExit;
+
+        if (vel[a] == 0) {
+            // Not moving on this axis, so it has to overlap already for the whole move
+            if (pMax[a] <= bMins[a] || pMin[a] >= bMaxs[a]) {
+                return -1;
+            }
+
+            continue;
+        }
+        else if (vel[a] > 0) {
+            axisEntry = SweepTime(bMins[a] - pMax[a], vel[a]);
+            axisExit = SweepTime(bMaxs[a] - pMin[a], vel[a]);
+        }
+        else {
+            axisEntry = SweepTime(bMaxs[a] - pMin[a], vel[a]);
+            axisExit = SweepTime(bMins[a] - pMax[a], vel[a]);
+        }
+
+        if (axisEntry > entry) {
+            entry = axisEntry;
+            *hitAxis = a;
+        }
+        if (axisExit < exit) {
+            exit = axisExit;
+        }
+    }
+
+    if (*hitAxis == -1 || entry >= exit || entry < 0 || entry > ONE) {
+        return -1;
+    }
+
+    return entry;
+}
+
+// Moves the player's position by its velocity, stopping at the first box in the way and sliding along it
+// This replaces a plain position + velocity, so fast moves and falls can't tunnel through thin boxes
+static void SweepPlayerMovement(VECTOR* position) {
+    long halfWidth = (player->poly.boxWidth / 2) * ONE;
+    long height = player->poly.boxHeight * ONE;
+    VECTOR move = player->poly.obj.velocity;
+
+    move.vx = (move.vx > MAXSWEEPSPEED) ? MAXSWEEPSPEED : (move.vx < -MAXSWEEPSPEED) ? -MAXSWEEPSPEED : move.vx;
+    move.vy = (move.vy > MAXSWEEPSPEED) ? MAXSWEEPSPEED : (move.vy < -MAXSWEEPSPEED) ? -MAXSWEEPSPEED : move.vy;
+    move.vz = (move.vz > MAXSWEEPSPEED) ? MAXSWEEPSPEED : (move.vz < -MAXSWEEPSPEED) ? -MAXSWEEPSPEED : move.vz;
+
+    for (int iteration = 0; iteration < SWEEPITERATIONS; iteration++) {
+        if (move.vx == 0 && move.vy == 0 && move.vz == 0) {
+            break;
+        }
+
+        VECTOR pMins = { position->vx - halfWidth, position->vy - height, position->vz - halfWidth, 0 };
+        VECTOR pMaxs = { position->vx + halfWidth, position->vy, position->vz + halfWidth, 0 };
+
+        // Broadphase over everything the move passes through
+        unsigned short candidates[COLQUERYMAX];
+        size_t candidateCount = ColGridQuery(
+            &collisionGrid,
+            (pMins.vx + ((move.vx < 0) ? move.vx : 0)) >> 12, (pMins.vz + ((move.vz < 0) ? move.vz : 0)) >> 12,
+            (pMaxs.vx + ((move.vx > 0) ? move.vx : 0)) >> 12, (pMaxs.vz + ((move.vz > 0) ? move.vz : 0)) >> 12,
+            candidates, COLQUERYMAX
+        );
+
+        long firstHit = ONE + 1;
+        int firstAxis = -1;
+        const StaticCollisionPolyBox* firstBox = NULL;
+
+        for (size_t c = 0; c < candidateCount; c++) {
+            const StaticCollisionPolyBox* scpolybox = activeCollisionPolyBoxes[candidates[c]];
+            int axis;
+
+            // Low boxes in front of a grounded player are stepped onto by the overlap resolver instead
+            if (isPlayerOnFloor && move.vy == 0) {
+                long stepheight = (position->vy - (scpolybox->position.vy - (scpolybox->colBox.dimensions.vy * ONE))) >> 12;
+
+                if (stepheight <= PLAYERSTEPHEIGHT && stepheight > 0) {
+                    continue;
+                }
+            }
+
+            long toi = SweepPlayerAgainstBox(&pMins, &pMaxs, &move, scpolybox, &axis);
+
+            if (toi >= 0 && toi < firstHit) {
+                firstHit = toi;
+                firstAxis = axis;
+                firstBox = scpolybox;
+            }
+        }
+
+        if (firstBox == NULL) {
+            addVector(position, &move);
+            break;
+        }
+
+        // Advance to the contact point. The hit axis is snapped to the box face, so rounding can't leave the player inside
+        long moved[3] = { (move.vx * firstHit) >> 12, (move.vy * firstHit) >> 12, (move.vz * firstHit) >> 12 };
+        long remaining[3] = { move.vx - moved[0], move.vy - moved[1], move.vz - moved[2] };
+
+        position->vx += moved[0];
+        position->vy += moved[1];
+        position->vz += moved[2];
+
+        if (firstAxis == 0) {
+            position->vx = (move.vx > 0) ? firstBox->position.vx - halfWidth : firstBox->position.vx + (firstBox->colBox.dimensions.vx * ONE) + halfWidth;
+            player->poly.obj.velocity.vx = 0;
+            remaining[0] = 0;
+        }
+        else if (firstAxis == 1) {
+            if (move.vy > 0) {
+                // Landed on top of the box
+                position->vy = firstBox->position.vy - (firstBox->colBox.dimensions.vy * ONE);
+                isPlayerOnCollision = true;
+            }
+            else {
+                position->vy = firstBox->position.vy + height;
+            }
+
+            player->poly.obj.velocity.vy = 0;
+            remaining[1] = 0;
+        }
+        else {
+            position->vz = (move.vz > 0) ? firstBox->position.vz - halfWidth : firstBox->position.vz + (firstBox->colBox.dimensions.vz * ONE) + halfWidth;
+            player->poly.obj.velocity.vz = 0;
+            remaining[2] = 0;
+        }
+
+        // Slide along the face with whatever is left of the move
+        setVector(&move, remaining[0], remaining[1], remaining[2]);
+    }
+}
+
 void SimulatePlayerMovementCollision() {
     isPlayerOnCollision = false;
     bool playerHasStepped = false;
 
     // In fixed-point units, aka 4096 = 1
     VECTOR playerSimulatedPosition = player->poly.obj.position;
-    addVector(&playerSimulatedPosition, &player->poly.obj.velocity);
+    SweepPlayerMovement(&playerSimulatedPosition);
     VECTOR playerSimulatedPositionFinal = playerSimulatedPosition; // This variable likely is not needed, but kept for now
 
     // Unsure if these should be recalculated per object, but probably not?
@@ -255,17 +453,27 @@ void SimulatePlayerMovementCollision() {
     VECTOR playerSimulatedPositionGridMins = { 
         (playerSimulatedPosition.vx >> 12) - player->poly.boxWidth / 2,
         (playerSimulatedPosition.vy >> 12),
-        (playerSimulatedPosition.vz >> 12) - player->poly.boxWidth / 2
+        (playerSimulatedPosition.vz >> 12) - player->poly.boxWidth / 2, 0
     };
 
     VECTOR playerSimulatedPositionGridMaxs = { 
         (playerSimulatedPosition.vx >> 12) + player->poly.boxWidth / 2,
         (playerSimulatedPosition.vy >> 12) - player->poly.boxHeight,
-        (playerSimulatedPosition.vz >> 12) + player->poly.boxWidth / 2
+        (playerSimulatedPosition.vz >> 12) + player->poly.boxWidth / 2, 0
     };
     
 
-    for (size_t i = 0; i < ACTIVECOLBOXCOUNT; i++) {
+    // Only the boxes sharing a grid cell with the player can overlap it
+    unsigned short candidates[COLQUERYMAX];
+    size_t candidateCount = ColGridQuery(
+        &collisionGrid, 
+        playerSimulatedPositionGridMins.vx, playerSimulatedPositionGridMins.vz, 
+        playerSimulatedPositionGridMaxs.vx, playerSimulatedPositionGridMaxs.vz, 
+        candidates, COLQUERYMAX
+    );
+
+    for (size_t c = 0; c < candidateCount; c++) {
+        size_t i = candidates[c];
         CollisionOverlaps overlaps = { 0 };
         bool stepping = false;
 
@@ -295,7 +503,7 @@ void SimulatePlayerMovementCollision() {
                     long stepheight = playerSimulatedPositionGridMins.vy - activeCollisionPolyBoxes[i]->transform.t[1] + activeCollisionPolyBoxes[i]->colBox.dimensions.vy;
                     //FntPrint("StepHeight: %03d\n", stepheight);
 
-                    if (stepheight <= 32 && stepheight > 0) {
+                    if (stepheight <= PLAYERSTEPHEIGHT && stepheight > 0) {
                         // Second simulated position to check if player is trying to step up into geometry
                         VECTOR playerStepPosition = playerSimulatedPositionFinal;
                         playerStepPosition.vy = activeCollisionPolyBoxes[i]->position.vy - (activeCollisionPolyBoxes[i]->colBox.dimensions.vy * ONE);
@@ -311,7 +519,7 @@ void SimulatePlayerMovementCollision() {
 
                 if (!stepping) {
                     // Bleeding, as in clipping/overlapping - not losing blood
-                    long bleed[3]; // X Y Z
+                    long bleed[3] = { 0, 0, 0 }; // X Y Z
 
                     long bleedXPos = abs((playerSimulatedPositionFinal.vx + ((player->poly.boxWidth / 2) * ONE)) - activeCollisionPolyBoxes[i]->position.vx);
                     long bleedXNeg = abs((playerSimulatedPositionFinal.vx - ((player->poly.boxWidth / 2) * ONE)) - (activeCollisionPolyBoxes[i]->position.vx + (activeCollisionPolyBoxes[i]->colBox.dimensions.vx * ONE)));
@@ -400,28 +608,17 @@ void SimulatePlayerMovementCollision() {
 }
 
 // Splits the dataBuffer into the other members for readability and ease of use
+// The bytes go through the replay system first, which records them or swaps in recorded ones. Only call this once per frame
 void UpdatePad(GamePad* pad) {
-    pad->status = pad->dataBuffer[0];
-    pad->type = pad->dataBuffer[1];
-    pad->buttons = 0xFFFF - ((pad->dataBuffer[2] << 8) | (pad->dataBuffer[3])); // Stores buffer[2] in the upper 8 bits and [3] in the lower 8 bits. Eases parsing later
-    pad->leftstick.x = pad->dataBuffer[6];
-    pad->leftstick.y = pad->dataBuffer[7];
-    pad->rightstick.x = pad->dataBuffer[4];
-    pad->rightstick.y = pad->dataBuffer[5];
-}
-
-// Lazy and likely fragile attempt at influencing sorting order
-static void OrderThing(long* otz, int dp) {
-    if (dp == DRP_Low) {
-        if (*otz + 256 < OTSIZE) {
-            *otz += 256;
-        }
-    }
-    else if (dp == DRP_High) {
-        if (*otz - 256 < OTSIZE) {
-            *otz -= 256;
-        }
-    }
+    const u_char* data = ReplayPad(pad->dataBuffer);
+
+    pad->status = data[0];
+    pad->type = data[1];
+    pad->buttons = 0xFFFF - ((data[2] << 8) | (data[3])); // Stores buffer[2] in the upper 8 bits and [3] in the lower 8 bits. Eases parsing later
+    pad->leftstick.x = data[6];
+    pad->leftstick.y = data[7];
+    pad->rightstick.x = data[4];
+    pad->rightstick.y = data[5];
 }
 
 long GetVectorPlaneLength64(VECTOR* vec) {
@@ -441,578 +638,2000 @@ long GetVectorPlaneLength64(VECTOR* vec) {
     return cC;
 }
 
-PolyObject* CreatePolyObjectF4(long posX, long posY, long posZ, short rotX, short rotY, short rotZ, ushort plen, ushort psides, SVECTOR* vertPtr, long* indPtr, enum DrawPriority drprio, bool coll, int collH, int collW, bool fixed, CVECTOR* col) {
-    PolyObject* pobj = calloc(1, sizeof(PolyObject));
-    POLY_F4* poly = calloc(plen, sizeof(POLY_F4));
-    VECTOR pos = { posX, posY, posZ };
-
-    if (pobj != NULL) {
-        setVector(&pobj->obj.position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
-        setVector(&pobj->obj.rotation, rotX, rotY, rotZ);
-        pobj->polyLength = plen;
-        pobj->polySides = psides;
-        pobj->verticesPtr = vertPtr;
-        pobj->indicesPtr = indPtr;
-        pobj->polyPtr = poly;
-        pobj->drPrio = drprio;
-        pobj->collides = coll;
-        pobj->boxHeight = collH;
-        pobj->boxWidth = collW;
-        pobj->obj.isStatic = fixed;
-        //platform->add = &AddPolyF;
-
-        for (size_t i = 0; i < plen; ++i) {
-            SetPolyF4(&poly[i]);
-            setRGB0(&poly[i], col[i].r, col[i].g, col[i].b);
-        }
-
-        RotMatrix_gte(&pobj->obj.rotation, &pobj->obj.transform);
-        TransMatrix(&pobj->obj.transform, &pos);
-    }
+// Moves the local bounding sphere centre along with the object's transform
+static void UpdateBoundsWorldCentre(BoundingSphere* bounds, MATRIX* transform) {
+    SVECTOR rotatedCentre;
 
-    return pobj;
+    ApplyMatrixSV(transform, &bounds->centre, &rotatedCentre);
+    setVector(&bounds->worldCentre, 
+        rotatedCentre.vx + transform->t[0], 
+        rotatedCentre.vy + transform->t[1], 
+        rotatedCentre.vz + transform->t[2]
+    );
 }
 
-POLY_FT4* CreateTexturedPolygon4(TIM_IMAGE* tim, u_char u0, u_char v0, u_char u1, u_char v1) {
-    POLY_FT4* poly = calloc(1, sizeof(POLY_FT4));
-    SetPolyFT4(poly);
+// Fits a bounding sphere around a local space box
+static void SetBoundsFromBox(BoundingSphere* bounds, const SVECTOR* mins, const SVECTOR* maxs, MATRIX* transform) {
+    long dx = maxs->vx - mins->vx;
+    long dy = maxs->vy - mins->vy;
+    long dz = maxs->vz - mins->vz;
 
-    poly->tpage = getTPage(tim->mode & 0x3, 0, tim->prect->x, tim->prect->y);
-    poly->clut = getClut(tim->crect->x, tim->crect->y);
-    setRGB0(poly, 128, 128, 128);
-    setUVWH(poly, u0, v0, u1, v1);
+    setVector(&bounds->centre, (mins->vx + maxs->vx) / 2, (mins->vy + maxs->vy) / 2, (mins->vz + maxs->vz) / 2);
+    bounds->radius = (SquareRoot0(dx * dx + dy * dy + dz * dz) / 2) + 1;
 
-    return poly;
+    UpdateBoundsWorldCentre(bounds, transform);
 }
 
-StaticCollisionPolyBox* CreateCollisionPolyBox(
-    long posX, long posY, long posZ,
-    short rotX, short rotY, short rotZ,
-    SVECTOR* vertPtr) {
+// Fits a bounding sphere around every vertex referenced by the first indexCount indices
+static void SetBoundsFromIndices(BoundingSphere* bounds, const SVECTOR* vertices, const long* indices, size_t indexCount, MATRIX* transform) {
+    SVECTOR mins = vertices[indices[0]];
+    SVECTOR maxs = vertices[indices[0]];
 
-    StaticCollisionPolyBox* scpolybox = malloc(sizeof(StaticCollisionPolyBox));
-    VECTOR pos = { posX, posY, posZ };
+    for (size_t i = 1; i < indexCount; i++) {
+        const SVECTOR* v = &vertices[indices[i]];
 
-    setVector(&scpolybox->position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
-    setVector(&scpolybox->rotation, rotX, rotY, rotZ);
-    scpolybox->vertices = vertPtr;
-    scpolybox->colBox.dimensions = scpolybox->vertices[5];
-    scpolybox->colBox.dimensions.vy = -scpolybox->colBox.dimensions.vy;
-    scpolybox->indices = cubeIndices;
+        if (v->vx < mins.vx) mins.vx = v->vx;
+        if (v->vy < mins.vy) mins.vy = v->vy;
+        if (v->vz < mins.vz) mins.vz = v->vz;
+        if (v->vx > maxs.vx) maxs.vx = v->vx;
+        if (v->vy > maxs.vy) maxs.vy = v->vy;
+        if (v->vz > maxs.vz) maxs.vz = v->vz;
+    }
 
-    for (size_t i = 0; i < 6; i++) {
-        scpolybox->polys[i] = NULL;
+    SetBoundsFromBox(bounds, &mins, &maxs, transform);
+}
+
+// Per-load state, tables inside the level image and cursors into the level arena
+typedef struct LevelLoader {
+    const LevelHeader* header;
+    SVECTOR* vertices;
+    long* indices;
+    const LevelMaterial* materials;
+    const u_short* faces;
+    size_t firstMaterialPrim; // materialPrims index of the level's first material
+    POLY_F4* polyF4s;
+    POLY_FT4* polyFT4s;
+    const LevelLod* lods;
+    bool usesCells; // The level's cells went into cellGraph, otherwise its objects are all left out of cells
+    u_short loaded[LOT_Count];
+    size_t nextLod;
+
+    LodLevel* nextLodLevel;
+} LevelLoader;
+
+#ifndef HOST
+// The console uses indices and flat templates straight out of the level image and copies its textured ones as they are,
+// so their layouts have to match
+typedef char LevelIndexSizeCheck[(sizeof(long) == sizeof(u_int)) ? 1 : -1];
+typedef char LevelPolyF4SizeCheck[(sizeof(POLY_F4) == sizeof(LevelPolyF4)) ? 1 : -1];
+typedef char LevelPolyFT4SizeCheck[(sizeof(POLY_FT4) == sizeof(LevelPolyFT4)) ? 1 : -1];
+#endif
+
+// Takes the next block of the level's allocation. Blocks are padded so every one of them stays aligned for its structs
+static void* TakeLevelMemory(size_t size) {
+    size = LEVELALIGN(size);
+
+    if (levelArenaUsed + size > sizeof(levelArena)) {
+        return NULL;
     }
 
-    RotMatrix_gte(&scpolybox->rotation, &scpolybox->transform);
-    TransMatrix(&scpolybox->transform, &pos);
+    void* block = (char*)levelArena + levelArenaUsed;
+    levelArenaUsed += size;
+    memset(block, 0, size);
 
-    return scpolybox;
+    return block;
 }
 
-// Used for creating a PolyObject out of a number of POLY_FT4 with the same textures
-TexturedPolyObject* CreateTexturedPolyObjectFT4(
-    long posX, long posY, long posZ, 
-    short rotX, short rotY, short rotZ, 
-    ushort plen, ushort psides, SVECTOR* vertPtr, long* indPtr, 
-    enum DrawPriority drprio, 
-    bool coll, int collH, int collW, bool fixed, 
-    TIM_IMAGE* tim, 
-    u_char u0, u_char v0, u_char uvwidth, u_char uvheight, 
-    bool repeating,
-    u_char twx, u_char twy, u_char tww, u_char twh) {
-    
-    TexturedPolyObject* tpobj = calloc(1, sizeof(TexturedPolyObject));
-    POLY_FT4* poly = calloc(plen, sizeof(POLY_FT4));
-    VECTOR pos = { posX, posY, posZ };
-    CVECTOR colour = { 128, 128, 128, 0 };
-
-    if (tpobj != NULL) {
-        setVector(&tpobj->polyObj.obj.position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
-        setVector(&tpobj->polyObj.obj.rotation, rotX, rotY, rotZ);
-        tpobj->polyObj.polyLength = plen;
-        tpobj->polyObj.polySides = psides;
-        tpobj->polyObj.verticesPtr = vertPtr;
-        tpobj->polyObj.indicesPtr = indPtr;
-        tpobj->polyObj.polyPtr = poly;
-        tpobj->polyObj.drPrio = drprio;
-        tpobj->polyObj.collides = coll;
-        tpobj->polyObj.boxHeight = collH;
-        tpobj->polyObj.boxWidth = collW;
-        tpobj->polyObj.obj.isStatic = fixed;
-        tpobj->tim = tim;
-        tpobj->repeating = repeating;
-        setRECT(&tpobj->trect, twx, twy, tww, twh);
-        //platform->add = &AddPolyF;
-
-        for (size_t i = 0; i < plen; ++i) {
-            SetPolyFT4(&poly[i]);
-            poly[i].tpage = getTPage(tim->mode & 0x3, 0, tim->prect->x, tim->prect->y);
-            poly[i].clut = getClut(tim->crect->x, tim->crect->y);
-            setRGB0(&poly[i], colour.r, colour.g, colour.b);
-            setUVWH(&poly[i], u0, v0, uvwidth, uvheight);
-        }
-
-        RotMatrix_gte(&tpobj->polyObj.obj.rotation, &tpobj->polyObj.obj.transform);
-        TransMatrix(&tpobj->polyObj.obj.transform, &pos);
-    }
-
-    return tpobj;
-}
-
-TestTileMultiPoly* CreateTestMultiPoly(
-    long posX, long posY, long posZ, 
-    short rotX, short rotY, short rotZ, 
-    u_char repeats, u_char subdivs, bool reverseOrder,
-    u_char rx, u_char ry, u_char rz,
-    u_char width, u_char height, u_char depth,
-    TIM_IMAGE* tim, 
-    u_char u0, u_char v0, u_char uvwidth, u_char uvheight) {
-    
-    TestTileMultiPoly* tmp = calloc(1, sizeof(TestTileMultiPoly));
-
-    SVECTOR* vertices = malloc(sizeof(SVECTOR) * 4);
-    if (vertices != NULL) {
-        if (width == 0) {
-            setVector(&vertices[0], 0, -height, 0);
-            setVector(&vertices[1], 0, -height, depth);
-            setVector(&vertices[2], 0, 0, depth);
-            setVector(&vertices[3], 0, 0, 0);
-        }
-        else if (height == 0) {
-            //setVector(&vertices[0], width, 0, 0);
-            //setVector(&vertices[1], width, 0, depth);
-            //setVector(&vertices[2], 0, 0, depth);
-            //setVector(&vertices[3], 0, 0, 0);
-
-            setVector(&vertices[0], 0, 0, depth);
-            setVector(&vertices[1], width, 0, depth);
-            setVector(&vertices[2], width, 0, 0);
-            setVector(&vertices[3], 0, 0, 0);
-            
-        }
-        else {
-            setVector(&vertices[0], 0, -height, 0);
-            setVector(&vertices[1], width, -height, 0);
-            setVector(&vertices[2], width, 0, 0);
-            setVector(&vertices[3], 0, 0, 0);
-        }
+// Checks the LOD records of an object, which follow the ones of the objects before it
+static bool AreLevelLodsValid(const LevelLoader* loader, const LevelObject* lobj) {
+    const LevelHeader* header = loader->header;
+    long lastDistance = 0;
+
+    if (lobj->lodCount == 0) {
+        return true;
     }
 
-    VECTOR pos = { posX, posY, posZ };
-    CVECTOR colour = { 128, 128, 128, 0 };
+    if (lobj->type == LOT_TiledFT4 || lobj->type == LOT_MultiPoly || loader->nextLod + lobj->lodCount > header->lodCount) {
+        return false;
+    }
 
-    if (tmp != NULL) {
-        setVector(&tmp->obj.position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
-        setVector(&tmp->obj.rotation, rotX, rotY, rotZ);
-        tmp->repeats = repeats;
-        tmp->subdivs = subdivs;
-        tmp->totalPolys = repeats * (subdivs * subdivs);
-        tmp->width = width;
-        tmp->height = height;
-        tmp->depth = depth;
-        tmp->tim = tim;
-        tmp->reverseOrder = reverseOrder;
-        tmp->verticesPtr = vertices;
+    for (size_t l = 0; l < lobj->lodCount; l++) {
+        const LevelLod* llod = &loader->lods[loader->nextLod + l];
+        size_t indexCount = llod->polyLength * 4;
 
-        if (tmp->reverseOrder) {
-            tmp->indicesPtr = floorIndices;
+        // Only textured objects have anything but flat LODs, and colboxes keep their own mesh
+        if (llod->distance <= lastDistance || (!llod->flat && lobj->type != LOT_PolyFT4)
+            || llod->firstIndex + indexCount > header->indexCount
+            || llod->firstPoly + llod->polyLength > (llod->flat ? header->polyF4Count : header->polyFT4Count)) {
+            return false;
         }
-        else {
-            tmp->indicesPtr = tileWallIndices;
+
+        if (lobj->type == LOT_ColBox
+            && (llod->polyLength != 6 || llod->firstVertex != lobj->firstVertex || llod->firstIndex != lobj->firstIndex)) {
+            return false;
         }
 
-        POLY_FT4* poly = calloc(tmp->totalPolys, sizeof(POLY_FT4));
-        for (size_t i = 0; i < tmp->totalPolys; ++i) {
-            SetPolyFT4(&poly[i]);
-            poly[i].tpage = getTPage(tim->mode & 0x3, 0, tim->prect->x, tim->prect->y);
-            poly[i].clut = getClut(tim->crect->x, tim->crect->y);
-            setRGB0(&poly[i], colour.r, colour.g, colour.b);
+        for (size_t i = 0; i < indexCount; i++) {
+            if (llod->firstVertex + (u_long)loader->indices[llod->firstIndex + i] >= header->vertexCount) {
+                return false;
+            }
         }
 
-        u_char utemp = u0;
-        u_char vtemp = v0;
-        ushort uvtemp = 0;
+        lastDistance = llod->distance;
+    }
 
-        if (subdivs > 1) {
-            ushort polyCount = 0;
-            u_char divuwidth = uvwidth / subdivs;
-            u_char divvheight = uvheight / subdivs;
-            
-            for (size_t i = 0; i < subdivs; i++) {
-                for (size_t j = 0; j < repeats * subdivs; j++) {
-                    setUVWH(&poly[polyCount], utemp, vtemp, divuwidth, divvheight);
-                    polyCount++;
-
-                    uvtemp = utemp + divuwidth;
-                    if ((uvtemp - u0) >= uvwidth || uvtemp > 256) {
-                        utemp = u0;
-                    }
-                    else if (uvtemp == 256) {
-                        utemp = 255;
-                    }
-                    else {
-                        utemp += divuwidth;
-                    }
-                }
+    return true;
+}
 
-                uvtemp = vtemp + divvheight;
-                if ((uvtemp - v0) >= uvheight || uvtemp > 256) {
-                    vtemp = v0;
-                }
-                else if (uvtemp == 256) {
-                    vtemp = 255;
-                }
-                else {
-                    vtemp += divvheight;
-                }
+// Checks everything an object record points at before anything is built from it
+static bool IsLevelObjectValid(const LevelLoader* loader, const LevelObject* lobj) {
+    const LevelHeader* header = loader->header;
+    size_t indexCount;
+    size_t polyCount;
 
-                utemp = u0;
-            }
-        }
-        else {
-            for (size_t i = 0; i < tmp->totalPolys; i++) {
-                setUVWH(&poly[i], u0, v0, uvwidth, uvheight);
+    if (lobj->type >= LOT_Count || loader->loaded[lobj->type] >= header->objectCounts[lobj->type] || lobj->polySides != 4) {
+        return false;
+    }
+
+    switch (lobj->type) {
+        case LOT_PolyF4:
+        case LOT_PolyFT4:
+            indexCount = lobj->polyLength * lobj->polySides;
+            polyCount = lobj->polyLength;
+            break;
+        case LOT_TiledFT4:
+            indexCount = lobj->polySides; // Only the first face is used, then repeated
+            polyCount = lobj->polyLength;
+            break;
+        case LOT_MultiPoly: {
+            size_t columns = (lobj->polyLength * lobj->subdivs) + 1;
+            size_t latticeCount = columns * (lobj->subdivs + 1);
+
+            if (lobj->subdivs == 0 || latticeCount > MULTIPOLYMAXLATTICE || lobj->firstVertex + latticeCount > header->vertexCount
+                || lobj->firstIndex + 4 > header->indexCount) {
+                return false;
             }
-        }
 
-        tmp->polyPtr = poly;
+            // Corners can't reach past the next row and column
+            for (size_t i = 0; i < 4; i++) {
+                if ((u_long)loader->indices[lobj->firstIndex + i] > columns + 1) {
+                    return false;
+                }
+            }
 
-        RotMatrix_gte(&tmp->obj.rotation, &tmp->obj.transform);
-        TransMatrix(&tmp->obj.transform, &pos);
-    }
+            indexCount = 4;
+            polyCount = lobj->polyLength * lobj->subdivs * lobj->subdivs;
+            break;
+        }
+        default: // LOT_ColBox
+            if (lobj->firstVertex + 8 > header->vertexCount || lobj->firstPoly + 6 > header->faceCount) {
+                return false;
+            }
 
-    return tmp;
-}
+            for (size_t i = 0; i < 6; i++) {
+                u_short material = loader->faces[lobj->firstPoly + i];
 
-void CreatePlayer(CVECTOR* col) {
-    player = calloc(1, sizeof(PlayerObject));
+                if (material >= header->materialCount || loader->materials[material].texture >= TEX_Count) {
+                    return false;
+                }
+            }
 
-    CameraObject* camera = calloc(1, sizeof(CameraObject));
-    POLY_F4* pplayer = calloc(6, sizeof(POLY_F4));
-    VECTOR pos = { 0, 0, 0 };
+            indexCount = 24;
+            polyCount = 0; // Faces are drawn from their materials' templates
+            break;
+    }
 
-    if (player != NULL) {
-        setVector(&player->poly.obj.position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
-        player->poly.polyLength = 6;
-        player->poly.polySides = 4;
-        player->poly.verticesPtr = playerBoxVertices;
-        player->poly.indicesPtr = cubeIndices;
-        player->poly.polyPtr = pplayer;
-        player->poly.drPrio = DRP_Neutral;
-        player->poly.collides = false;
-        player->poly.boxHeight = PLAYERHEIGHT;
-        player->poly.boxWidth = PLAYERWIDTHHALF * 2;
-        player->poly.obj.maxSpeed = 5 * ONE;
-        player->poly.obj.isStatic = false;
-        //player->poly.add = &AddPolyF;
-
-        if (camera != NULL) {
-            player->cameraPtr = camera;
-        }
+    if (lobj->firstIndex + indexCount > header->indexCount) {
+        return false;
+    }
 
-        for (size_t i = 0; i < 6; ++i) {
-            SetPolyF4(&pplayer[i]);
-            setRGB0(&pplayer[i], col[i].r, col[i].g, col[i].b);
+    for (size_t i = 0; i < indexCount; i++) {
+        if (lobj->firstVertex + (u_long)loader->indices[lobj->firstIndex + i] >= header->vertexCount) {
+            return false;
         }
+    }
 
-        RotMatrix_gte(&player->poly.obj.rotation, &player->poly.obj.transform);
-        TransMatrix(&player->poly.obj.transform, &pos);
+    // Textured objects still need their material for the TIM and texture window
+    if (lobj->type != LOT_PolyF4
+        && (lobj->firstMaterial >= header->materialCount || loader->materials[lobj->firstMaterial].texture >= TEX_Count)) {
+        return false;
     }
-}
 
-// Update poly matrix
-static void UpdatePolyObject(PolyObject* pobj) {
-    // If object can move in any way, apply velocity
-    if (!pobj->obj.isStatic) {
-        /*
-        if (GetVectorPlaneLength64(&pobj->obj.velocity) > (pobj->obj.maxSpeed << 6)) {
-            VECTOR appliedVelocity = { 0 };
+    if (lobj->type != LOT_ColBox && lobj->firstPoly + polyCount > ((lobj->type == LOT_PolyF4) ? header->polyF4Count : header->polyFT4Count)) {
+        return false;
+    }
 
-            VectorNormal(&pobj->obj.velocity, &appliedVelocity);
-            appliedVelocity.vx *= pobj->obj.maxSpeed * ONE;
-            appliedVelocity.vz *= pobj->obj.maxSpeed * ONE;
+    // Only objects that never move can be in a cell, they aren't looked up again
+    if (lobj->cell != LEVELNOCELL
+        && ((lobj->cell >= header->cellCount && lobj->cell != LEVELOUTSIDE) || (lobj->type != LOT_ColBox && !(lobj->flags & LOF_Static)))) {
+        return false;
+    }
 
-            addVector(&pobj->obj.position, &appliedVelocity);
-        }
-        else {
-            addVector(&pobj->obj.position, &pobj->obj.velocity);
-        }
-        */
-        
-        VECTOR gridPos = { 
-            pobj->obj.position.vx >> 12, 
-            pobj->obj.position.vy >> 12, 
-            pobj->obj.position.vz >> 12 
-        };
+    return AreLevelLodsValid(loader, lobj);
+}
 
-        RotMatrix_gte(&pobj->obj.rotation, &pobj->obj.transform);
-        TransMatrix(&pobj->obj.transform, &gridPos);
-    }
+// Cell an object of the level goes in
+static u_char LoadCell(const LevelLoader* loader, const LevelObject* lobj) {
+    return loader->usesCells ? lobj->cell : LEVELNOCELL;
 }
 
-static void CameraTransformMatrix(CameraObject* camera, MATRIX* matrix) {
-    // Could get away with replacing this with a global instead of storing the render transform in every object
-    gte_CompMatrix(&camera->transform, matrix, &globalRenderTransform);
-        
-    gte_SetRotMatrix(&globalRenderTransform);
-    gte_SetTransMatrix(&globalRenderTransform);
+static void LoadGameObject(const LevelLoader* loader, GameObject* obj, const LevelObject* lobj) {
+    VECTOR pos = { lobj->position[0], lobj->position[1], lobj->position[2], 0 };
+
+    setVector(&obj->position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
+    setVector(&obj->rotation, lobj->rotation[0], lobj->rotation[1], lobj->rotation[2]);
+    obj->isStatic = (lobj->flags & LOF_Static) != 0;
+    obj->autoRotates = (lobj->flags & LOF_AutoRotate) != 0;
+    obj->cell = LoadCell(loader, lobj);
+
+    RotMatrix_gte(&obj->rotation, &obj->transform);
+    TransMatrix(&obj->transform, &pos);
+    obj->transformRotation = obj->rotation;
 }
 
-static void AddPolyF(PolyObject* pobj, u_long* ot) {
-    long p, otz, flg;
-    int nclip;
+// Bounding spheres are fitted by the level compiler, only the world centre depends on the transform
+static void LoadBounds(BoundingSphere* bounds, const LevelObject* lobj, MATRIX* transform) {
+    setVector(&bounds->centre, lobj->boundsCentre[0], lobj->boundsCentre[1], lobj->boundsCentre[2]);
+    bounds->radius = lobj->boundsRadius;
 
-    if (pobj->polySides == 4) {
-        POLY_F4* poly = (POLY_F4*)pobj->polyPtr;
+    UpdateBoundsWorldCentre(bounds, transform);
+}
 
-        for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++poly) {
-            // Non-Average version (RotNclip4) presents layering issues, at least tested on floor against Average cube
-            nclip = RotAverageNclip4(
-                &pobj->verticesPtr[pobj->indicesPtr[i + 0]], &pobj->verticesPtr[pobj->indicesPtr[i + 1]],
-                &pobj->verticesPtr[pobj->indicesPtr[i + 2]], &pobj->verticesPtr[pobj->indicesPtr[i + 3]],
-                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &p, &otz, &flg
-            );
+// Vertices a mesh uses, counted from its first one
+static u_short MeshVertexCount(const long* indices, size_t indexCount) {
+    long highest = 0;
 
-            if (nclip <= 0) {
-                continue;
-            }
-            
-            if ((otz > 0) && (otz < OTSIZE)) {
-                OrderThing(&otz, pobj->drPrio);
-                AddPrim(&ot[otz], poly);
-            }
+    for (size_t i = 0; i < indexCount; i++) {
+        if (indices[i] > highest) {
+            highest = indices[i];
         }
     }
-    else if (pobj->polySides == 3) {
-        POLY_F3* poly = (POLY_F3*)pobj->polyPtr;
 
-        for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++poly) {
-            nclip = RotAverageNclip3(
-                &pobj->verticesPtr[pobj->indicesPtr[i + 0]], &pobj->verticesPtr[pobj->indicesPtr[i + 1]],
-                &pobj->verticesPtr[pobj->indicesPtr[i + 2]],
-                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x2, &p, &otz, &flg
-            );
+    return highest + 1;
+}
 
-            if (nclip <= 0) {
-                continue;
-            }
+// Templates are baked against the TIM's own VRAM position, not where LoadTexture() put it. Every template
+// belongs to one object, whose material says which texture it uses, so CLUT-less TIMs sharing a tpage stay apart
+// Only level arena copies are moved, the image keeps its baked UVs so the level can be loaded again
+static void RelocateLevelPrims(const LevelLoader* loader, const LevelObject* lobj, POLY_FT4* polys, size_t count) {
+    enum TextureID texture = loader->materials[lobj->firstMaterial].texture;
 
-            if ((otz > 0) && (otz < OTSIZE)) {
-                OrderThing(&otz, pobj->drPrio);
-                AddPrim(&ot[otz], poly);
-            }
-        }
+    for (size_t i = 0; i < count; i++) {
+        RelocateTexturedPrim(&polys[i], texture);
     }
 }
 
-//static void AddPolyFT(PolyObject* pobj, DR_TPAGE* tpage, u_long* ot) {
-static void AddPolyFT(TexturedPolyObject* tpobj, u_long* ot) {
-    long p, otz, flg;
-    int nclip;
+// Builds an object's LOD levels after full, the mesh it was loaded with. Returns NULL if it has no LODs
+static LodLevel* LoadLods(LevelLoader* loader, const LevelObject* lobj, const LodLevel* full) {
+    if (lobj->lodCount == 0) {
+        return NULL;
+    }
 
-    if (tpobj->polyObj.polySides == 4) {
-        POLY_FT4* poly = (POLY_FT4*)tpobj->polyObj.polyPtr;
+    LodLevel* levels = loader->nextLodLevel;
+    loader->nextLodLevel += lobj->lodCount + 1;
+    levels[0] = *full;
+
+    for (size_t l = 1; l <= lobj->lodCount; l++) {
+        const LevelLod* llod = &loader->lods[loader->nextLod++];
+        LodLevel* level = &levels[l];
+
+        level->distance = llod->distance;
+        level->polyPtr = llod->flat ? (void*)&loader->polyF4s[llod->firstPoly] : (void*)&loader->polyFT4s[llod->firstPoly];
+        level->verticesPtr = &loader->vertices[llod->firstVertex];
+        level->indicesPtr = &loader->indices[llod->firstIndex];
+        level->polyLength = llod->polyLength;
+        level->vertexCount = MeshVertexCount(level->indicesPtr, level->polyLength * 4);
+        level->flat = llod->flat;
+        level->batchTransform = (lobj->flags & LOF_BatchTransform) && level->vertexCount <= MESHCACHESIZE;
+
+        if (!level->flat) {
+            RelocateLevelPrims(loader, lobj, level->polyPtr, level->polyLength);
+        }
+    }
 
-        for (size_t i = 0; i < (tpobj->polyObj.polyLength * tpobj->polyObj.polySides); i += tpobj->polyObj.polySides, ++poly) {
-            // Non-Average version (RotNclip4) presents layering issues, at least tested on floor against Average cube
-            nclip = RotAverageNclip4(
-                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 0]], &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 1]],
-                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 2]], &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 3]],
-                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &p, &otz, &flg
-            );
+    return levels;
+}
 
-            if (nclip <= 0) {
-                continue;
-            }
-            
-            if ((otz > 0) && (otz < OTSIZE)) {
-                OrderThing(&otz, tpobj->polyObj.drPrio);
-                AddPrim(&ot[otz], poly);
-
-                /*
-                if (tpobj->repeating) {
-                    curTPage = poly->tpage;
-                    DR_MODE* drMode = &drModeList[curdrModeIndex];
-                    setDrawMode(drMode, 0, 1, curTPage, &tpobj->trect);
-                    curdrModeIndex++;
-                    AddPrim(&ot[otz], drMode);
-
-                    //DR_MODE* drModeReset = &drModeList[curdrModeIndex];
-                    //setDrawMode(drModeReset, 0, 1, curTPage, &resetRect);
-                    //curdrModeIndex++;
-                    //AddPrim(&ot[otz], &drModeReset);
-                }
-                */
-            }
-        }
+static void LoadPolyObject(LevelLoader* loader, PolyObject* pobj, const LevelObject* lobj, void* polys) {
+    LoadGameObject(loader, &pobj->obj, lobj);
+
+    pobj->polyLength = lobj->polyLength;
+    pobj->polySides = lobj->polySides;
+    pobj->verticesPtr = &loader->vertices[lobj->firstVertex];
+    pobj->indicesPtr = &loader->indices[lobj->firstIndex];
+    pobj->polyPtr = polys;
+    pobj->drPrio = lobj->drPrio;
+    pobj->collides = (lobj->flags & LOF_Collides) != 0;
+    pobj->boxHeight = lobj->boxHeight;
+    pobj->boxWidth = lobj->boxWidth;
+
+    // Tiled objects move their vertices per tile, so only plain meshes can go through the screen cache
+    if (lobj->type != LOT_TiledFT4) {
+        pobj->vertexCount = MeshVertexCount(pobj->indicesPtr, pobj->polyLength * pobj->polySides);
+        pobj->batchTransform = (lobj->flags & LOF_BatchTransform) && pobj->vertexCount <= MESHCACHESIZE;
     }
-    else if (tpobj->polyObj.polySides == 3) {
-        POLY_FT3* poly = (POLY_FT3*)tpobj->polyObj.polyPtr;
 
-        for (size_t i = 0; i < (tpobj->polyObj.polyLength * tpobj->polyObj.polySides); i += tpobj->polyObj.polySides, ++poly) {
-            nclip = RotAverageNclip3(
-                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 0]], &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 1]],
-                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 2]],
-                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x2, &p, &otz, &flg
-            );
+    LoadBounds(&pobj->bounds, lobj, &pobj->obj.transform);
 
-            if (nclip <= 0) {
-                continue;
-            }
+    LodLevel full = { 0, pobj->polyPtr, pobj->verticesPtr, pobj->indicesPtr, pobj->polyLength, pobj->vertexCount, false, pobj->batchTransform };
+    pobj->lods = LoadLods(loader, lobj, &full);
+    pobj->lodCount = (pobj->lods != NULL) ? lobj->lodCount + 1 : 0;
+    pobj->lod = 0;
+}
 
-            if ((otz > 0) && (otz < OTSIZE)) {
-                OrderThing(&otz, tpobj->polyObj.drPrio);
-                AddPrim(&ot[otz], poly);
+static void LoadPolyF4Object(LevelLoader* loader, const LevelObject* lobj) {
+    PolyObject* pobj = PoolAlloc(&polyObjectPool);
 
-                curTPage = poly->tpage;
-                DR_MODE* drMode = &drModeList[curdrModeIndex];
-                setDrawMode(drMode, 0, 1, curTPage, &tpobj->trect);
+    LoadPolyObject(loader, pobj, lobj, &loader->polyF4s[lobj->firstPoly]);
+    activePolygons[activePolygonCount++] = pobj;
+}
 
-                AddPrim(&ot[otz], drMode);
-                curdrModeIndex++;
-            }
-        }
+// Works out when an object needs the texture window, so objects whose UVs stay inside it never pay for the DR_MODEs
+// All faces of an object share one material, so the first template stands in for all of them
+static void LoadTextureWindow(TexturedPolyObject* tpobj, bool tiled) {
+    const POLY_FT4* tmpl = tpobj->polyObj.polyPtr;
+    const RECT* window = &tpobj->trect;
+    u_char u[4] = { tmpl->u0, tmpl->u1, tmpl->u2, tmpl->u3 };
+    u_char v[4] = { tmpl->v0, tmpl->v1, tmpl->v2, tmpl->v3 };
+    long uMin = 255;
+    long uMax = 0;
+    bool outside = false;
+
+    for (size_t k = 0; k < 4; k++) {
+        uMin = (u[k] < uMin) ? u[k] : uMin;
+        uMax = (u[k] > uMax) ? u[k] : uMax;
+        outside |= u[k] < window->x || u[k] > window->x + window->w || v[k] < window->y || v[k] > window->y + window->h;
     }
-}
+
+    tpobj->windowed = tpobj->repeating && window->w != 0 && outside;
+    tpobj->windowTiles = 1;
+
+    // A face spanning exactly one window width from a window edge wraps back onto itself, tile after tile
+    // U has to grow along X, the same way the tiles go, which is how the level compiler lays them out
+    // Only repeating objects get the texture window, without it the stretched U would run off the texture
+    if (tiled && tpobj->repeating && window->w != 0 && uMax - uMin == window->w && (uMin - window->x) % window->w == 0) {
+        tpobj->windowTiles = 1 + ((255 - uMax) / window->w);
+    }
+}
+
+// Used for both plain and tiled textured objects, all faces share one material
+static void LoadTexturedObject(LevelLoader* loader, const LevelObject* lobj) {
+    TexturedPolyObject* tpobj = PoolAlloc(&texObjectPool);
+    const LevelMaterial* material = &loader->materials[lobj->firstMaterial];
+    const TexturePlacement* placement = &texturePlacements[material->texture];
+
+    RelocateLevelPrims(loader, lobj, &loader->polyFT4s[lobj->firstPoly], lobj->polyLength);
+    LoadPolyObject(loader, &tpobj->polyObj, lobj, &loader->polyFT4s[lobj->firstPoly]);
+    tpobj->tim = textureTable[material->texture];
+    tpobj->repeating = (lobj->flags & LOF_Repeating) != 0;
+    tpobj->subdivides = (lobj->type == LOT_PolyFT4) && (lobj->flags & LOF_Subdivide) && lobj->polySides == 4;
+    // The window moves along with the texture, like the templates did in LoadLevel()
+    setRECT(&tpobj->trect, material->twx + placement->du, material->twy + placement->dv, material->tww, material->twh);
+    LoadTextureWindow(tpobj, lobj->type == LOT_TiledFT4);
+
+    if (lobj->type == LOT_PolyFT4) {
+        activeTexPolygons[activeTexPolygonCount++] = tpobj;
+    }
+    else {
+        activeTiledTexPolygons[activeTiledTexPolygonCount++] = tpobj;
+    }
+}
+
+// The subdivided UVs are baked into the templates by the level compiler
+static void LoadMultiPoly(LevelLoader* loader, const LevelObject* lobj) {
+    TestTileMultiPoly* tmp = PoolAlloc(&multiPolyPool);
+    const LevelMaterial* material = &loader->materials[lobj->firstMaterial];
+
+    LoadGameObject(loader, &tmp->obj, lobj);
+    tmp->repeats = lobj->polyLength;
+    tmp->subdivs = lobj->subdivs;
+    tmp->totalPolys = tmp->repeats * (tmp->subdivs * tmp->subdivs);
+    tmp->width = lobj->width;
+    tmp->height = lobj->height;
+    tmp->depth = lobj->depth;
+    tmp->tim = textureTable[material->texture];
+    tmp->reverseOrder = (lobj->flags & LOF_ReverseOrder) != 0;
+    tmp->verticesPtr = &loader->vertices[lobj->firstVertex];
+    tmp->indicesPtr = &loader->indices[lobj->firstIndex];
+    tmp->polyPtr = &loader->polyFT4s[lobj->firstPoly];
+    RelocateLevelPrims(loader, lobj, tmp->polyPtr, tmp->totalPolys);
+
+    LoadBounds(&tmp->bounds, lobj, &tmp->obj.transform);
+    activeMultiPolys[activeMultiPolyCount++] = tmp;
+}
+
+static void LoadCollisionPolyBox(LevelLoader* loader, const LevelObject* lobj) {
+    StaticCollisionPolyBox* scpolybox = PoolAlloc(&colBoxPool);
+    VECTOR pos = { lobj->position[0], lobj->position[1], lobj->position[2], 0 };
+
+    setVector(&scpolybox->position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
+    setVector(&scpolybox->rotation, lobj->rotation[0], lobj->rotation[1], lobj->rotation[2]);
+    scpolybox->vertices = &loader->vertices[lobj->firstVertex];
+    scpolybox->colBox.dimensions = scpolybox->vertices[5];
+    scpolybox->colBox.dimensions.vy = -scpolybox->colBox.dimensions.vy;
+    scpolybox->indices = &loader->indices[lobj->firstIndex];
+
+    for (size_t i = 0; i < 6; i++) {
+        scpolybox->faceMaterials[i] = loader->firstMaterialPrim + loader->faces[lobj->firstPoly + i];
+    }
+
+    scpolybox->batchTransform = (lobj->flags & LOF_BatchTransform) != 0;
+    scpolybox->cell = LoadCell(loader, lobj);
+
+    RotMatrix_gte(&scpolybox->rotation, &scpolybox->transform);
+    TransMatrix(&scpolybox->transform, &pos);
+    LoadBounds(&scpolybox->bounds, lobj, &scpolybox->transform);
+
+    LodLevel full = { 0, NULL, scpolybox->vertices, scpolybox->indices, 6, 8, false, scpolybox->batchTransform };
+    scpolybox->lods = LoadLods(loader, lobj, &full);
+    scpolybox->lodCount = (scpolybox->lods != NULL) ? lobj->lodCount + 1 : 0;
+    scpolybox->lod = 0;
+
+    activeCollisionPolyBoxes[activeCollisionPolyBoxCount++] = scpolybox;
+}
+
+#ifdef HOST
+// The host's longs and primitive tags are 8 bytes, so its indices and templates are widened copies of the image's
+static void ConvertLevelPrims(LevelLoader* loader, const char* image) {
+    const LevelHeader* header = loader->header;
+    const u_int* indices = (const u_int*)(image + header->indexOffset);
+    const LevelPolyF4* polyF4s = (const LevelPolyF4*)(image + header->polyF4Offset);
+    const LevelPolyFT4* polyFT4s = (const LevelPolyFT4*)(image + header->polyFT4Offset);
+
+    for (size_t i = 0; i < header->indexCount; i++) {
+        loader->indices[i] = indices[i];
+    }
+
+    for (size_t i = 0; i < header->polyF4Count; i++) {
+        POLY_F4* poly = &loader->polyF4s[i];
+
+        SetPolyF4(poly);
+        setRGB0(poly, polyF4s[i].r0, polyF4s[i].g0, polyF4s[i].b0);
+    }
+
+    for (size_t i = 0; i < header->polyFT4Count; i++) {
+        POLY_FT4* poly = &loader->polyFT4s[i];
+        const LevelPolyFT4* lpoly = &polyFT4s[i];
+
+        SetPolyFT4(poly);
+        setRGB0(poly, lpoly->r0, lpoly->g0, lpoly->b0);
+        poly->tpage = lpoly->tpage;
+        poly->clut = lpoly->clut;
+        setUV4(poly, lpoly->u0, lpoly->v0, lpoly->u1, lpoly->v1, lpoly->u2, lpoly->v2, lpoly->u3, lpoly->v3);
+    }
+}
+#endif
+
+// Builds a template from each of the level's materials, from the level's first slot in materialPrims on
+// Flat materials get none, IsLevelObjectValid() keeps faces off them
+static void LoadMaterialPrims(LevelLoader* loader) {
+    const LevelHeader* header = loader->header;
+
+    loader->firstMaterialPrim = materialPrimCount;
+
+    for (size_t i = 0; i < header->materialCount; i++) {
+        const LevelMaterial* material = &loader->materials[i];
+        POLY_FT4* poly = &materialPrims[materialPrimCount++];
+
+        if (material->texture >= TEX_Count) {
+            continue;
+        }
+
+        SetPolyFT4(poly);
+        setRGB0(poly, material->r, material->g, material->b);
+        SetTexturedPrim(poly, material->texture, material->u0, material->v0, material->uvwidth, material->uvheight);
+    }
+}
+
+// Uses the collision grid baked into the level if it covers exactly the active boxes, otherwise builds one
+// The baked grid indexes the level's boxes from 0, so it only fits when the level is the first to add any
+static void LoadCollisionGrid(const char* image, size_t size, size_t firstCollisionPolyBox, u_short* boxStamps) {
+    const LevelHeader* header = (const LevelHeader*)image;
+
+    ColGridFree(&collisionGrid);
+
+    if (header->gridOffset != 0 && firstCollisionPolyBox == 0 && header->objectCounts[LOT_ColBox] > 0
+        && ColGridAttach(&collisionGrid, (const ColGridImage*)(image + header->gridOffset), size - header->gridOffset, boxStamps, activeCollisionPolyBoxCount)) {
+        return;
+    }
+
+    BuildCollisionGrid();
+}
+
+// Copies count vertices into out, moved into world space by transform
+// Returns false if one of them ends up outside of what an SVECTOR holds, the object then keeps drawing with its own matrix
+static bool BakeVertices(const SVECTOR* vertices, size_t count, MATRIX* transform, SVECTOR* out) {
+    for (size_t v = 0; v < count; v++) {
+        VECTOR local = { vertices[v].vx, vertices[v].vy, vertices[v].vz, 0 };
+        VECTOR world;
+
+        ApplyMatrixLV(transform, &local, &world);
+        world.vx += transform->t[0];
+        world.vy += transform->t[1];
+        world.vz += transform->t[2];
+
+        if (world.vx < -32768 || world.vx > 32767 || world.vy < -32768 || world.vy > 32767
+            || world.vz < -32768 || world.vz > 32767) {
+            return false;
+        }
+
+        setVector(&out[v], world.vx, world.vy, world.vz);
+    }
+
+    return true;
+}
+
+// Plain and textured objects share everything chunking needs through their PolyObject
+static PolyObject* ChunkPolyObject(const ChunkMember* member) {
+    return (member->type == LOT_PolyFT4) ? &((TexturedPolyObject*)member->object)->polyObj : (PolyObject*)member->object;
+}
+
+static BoundingSphere* ChunkMemberBounds(const ChunkMember* member) {
+    switch (member->type) {
+        case LOT_PolyF4:
+        case LOT_PolyFT4:
+            return &ChunkPolyObject(member)->bounds;
+        case LOT_MultiPoly:
+            return &((TestTileMultiPoly*)member->object)->bounds;
+        default: // LOT_ColBox
+            return &((StaticCollisionPolyBox*)member->object)->bounds;
+    }
+}
+
+// World space vertices a member needs, one copy for its full mesh and one per LOD past it
+static size_t ChunkMemberVertexCount(const ChunkMember* member) {
+    switch (member->type) {
+        case LOT_PolyF4:
+        case LOT_PolyFT4: {
+            const PolyObject* pobj = ChunkPolyObject(member);
+            size_t count = pobj->vertexCount;
+
+            for (size_t l = 1; l < pobj->lodCount; l++) {
+                count += pobj->lods[l].vertexCount;
+            }
+
+            return count;
+        }
+        case LOT_MultiPoly: {
+            const TestTileMultiPoly* tmp = member->object;
+
+            return ((tmp->repeats * tmp->subdivs) + 1) * (tmp->subdivs + 1);
+        }
+        default: // LOT_ColBox, whose LODs keep its corners
+            return 8;
+    }
+}
+
+// Chunks are runs of members with the same key, one per cell and tpage. Flat objects go together under 0xFFFF
+static u_long ChunkMemberKey(const ChunkMember* member) {
+    const BoundingSphere* bounds = ChunkMemberBounds(member);
+    u_long cellX = (bounds->worldCentre.vx >> CHUNKCELLSHIFT) & 0xFF;
+    u_long cellZ = (bounds->worldCentre.vz >> CHUNKCELLSHIFT) & 0xFF;
+    u_short tpage = 0xFFFF;
+
+    switch (member->type) {
+        case LOT_PolyFT4:
+            tpage = ((POLY_FT4*)ChunkPolyObject(member)->polyPtr)->tpage;
+            break;
+        case LOT_MultiPoly:
+            tpage = ((TestTileMultiPoly*)member->object)->polyPtr->tpage;
+            break;
+        case LOT_ColBox:
+            tpage = materialPrims[((StaticCollisionPolyBox*)member->object)->faceMaterials[0]].tpage;
+            break;
+    }
+
+    return (cellX << 24) | (cellZ << 16) | tpage;
+}
+
+// Moves a member's meshes into world space at out, its transform then only matters for collision
+// Nothing is switched over unless every mesh of the member made it
+static bool BakeChunkMember(ChunkMember* member, SVECTOR* out) {
+    switch (member->type) {
+        case LOT_PolyF4:
+        case LOT_PolyFT4: {
+            PolyObject* pobj = ChunkPolyObject(member);
+            SVECTOR* next = out + pobj->vertexCount;
+
+            if (!BakeVertices(pobj->verticesPtr, pobj->vertexCount, &pobj->obj.transform, out)) {
+                return false;
+            }
+
+            for (size_t l = 1; l < pobj->lodCount; l++) {
+                if (!BakeVertices(pobj->lods[l].verticesPtr, pobj->lods[l].vertexCount, &pobj->obj.transform, next)) {
+                    return false;
+                }
+
+                next += pobj->lods[l].vertexCount;
+            }
+
+            pobj->verticesPtr = out;
+            next = out + pobj->vertexCount;
+
+            if (pobj->lods != NULL) {
+                pobj->lods[0].verticesPtr = out;
+            }
+
+            for (size_t l = 1; l < pobj->lodCount; l++) {
+                pobj->lods[l].verticesPtr = next;
+                next += pobj->lods[l].vertexCount;
+            }
+
+            pobj->obj.chunked = true;
+            return true;
+        }
+        case LOT_MultiPoly: {
+            TestTileMultiPoly* tmp = member->object;
+
+            if (!BakeVertices(tmp->verticesPtr, ChunkMemberVertexCount(member), &tmp->obj.transform, out)) {
+                return false;
+            }
+
+            tmp->verticesPtr = out;
+            tmp->obj.chunked = true;
+            return true;
+        }
+        default: { // LOT_ColBox
+            StaticCollisionPolyBox* scpolybox = member->object;
+
+            if (!BakeVertices(scpolybox->vertices, 8, &scpolybox->transform, out)) {
+                return false;
+            }
+
+            scpolybox->vertices = out;
+
+            for (size_t l = 0; l < scpolybox->lodCount; l++) {
+                scpolybox->lods[l].verticesPtr = out;
+            }
+
+            scpolybox->chunked = true;
+            return true;
+        }
+    }
+}
+
+// Sphere around all of a chunk's members, centred on the box their spheres fill
+static void SetChunkBounds(StaticChunk* chunk) {
+    VECTOR mins = { 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0 };
+    VECTOR maxs = { -0x7FFFFFFF, -0x7FFFFFFF, -0x7FFFFFFF, 0 };
+    long radius = 0;
+
+    for (size_t m = 0; m < chunk->memberCount; m++) {
+        const BoundingSphere* bounds = ChunkMemberBounds(&chunkMembers[chunk->firstMember + m]);
+        long r = bounds->radius;
+
+        mins.vx = (bounds->worldCentre.vx - r < mins.vx) ? bounds->worldCentre.vx - r : mins.vx;
+        mins.vy = (bounds->worldCentre.vy - r < mins.vy) ? bounds->worldCentre.vy - r : mins.vy;
+        mins.vz = (bounds->worldCentre.vz - r < mins.vz) ? bounds->worldCentre.vz - r : mins.vz;
+        maxs.vx = (bounds->worldCentre.vx + r > maxs.vx) ? bounds->worldCentre.vx + r : maxs.vx;
+        maxs.vy = (bounds->worldCentre.vy + r > maxs.vy) ? bounds->worldCentre.vy + r : maxs.vy;
+        maxs.vz = (bounds->worldCentre.vz + r > maxs.vz) ? bounds->worldCentre.vz + r : maxs.vz;
+    }
+
+    setVector(&chunk->bounds.worldCentre, (mins.vx + maxs.vx) / 2, (mins.vy + maxs.vy) / 2, (mins.vz + maxs.vz) / 2);
+
+    for (size_t m = 0; m < chunk->memberCount; m++) {
+        const BoundingSphere* bounds = ChunkMemberBounds(&chunkMembers[chunk->firstMember + m]);
+        long dx = bounds->worldCentre.vx - chunk->bounds.worldCentre.vx;
+        long dy = bounds->worldCentre.vy - chunk->bounds.worldCentre.vy;
+        long dz = bounds->worldCentre.vz - chunk->bounds.worldCentre.vz;
+        long reach = SquareRoot0(dx * dx + dy * dy + dz * dz) + bounds->radius + 1;
+
+        radius = (reach > radius) ? reach : radius;
+    }
+
+    chunk->bounds.radius = radius;
+}
+
+static u_char ChunkMemberCell(const ChunkMember* member) {
+    switch (member->type) {
+        case LOT_PolyF4:
+        case LOT_PolyFT4:
+            return ChunkPolyObject(member)->obj.cell;
+        case LOT_MultiPoly:
+            return ((TestTileMultiPoly*)member->object)->obj.cell;
+        default: // LOT_ColBox
+            return ((StaticCollisionPolyBox*)member->object)->cell;
+    }
+}
+
+// Candidate member while chunks are built. Chunks never mix level cells, so a whole chunk can be skipped by its cell
+typedef struct ChunkCandidate {
+    u_char cell;
+    u_long key; // See ChunkMemberKey()
+    ChunkMember member;
+} ChunkCandidate;
+
+static void AddChunkCandidate(ChunkCandidate* candidates, size_t* count, u_char type, void* object) {
+    ChunkCandidate* candidate = &candidates[(*count)++];
+
+    candidate->member.type = type;
+    candidate->member.object = object;
+    candidate->cell = ChunkMemberCell(&candidate->member);
+    candidate->key = ChunkMemberKey(&candidate->member);
+}
+
+static bool IsChunkCandidateAfter(const ChunkCandidate* a, const ChunkCandidate* b) {
+    return (a->cell != b->cell) ? a->cell > b->cell : a->key > b->key;
+}
+
+// Bakes the static objects a level just added into world space and groups them into chunks by level cell, spatial cell and tpage
+// Chunked objects are skipped by the per-kind loops in main() and drawn by AddStaticChunks() instead, under the
+// camera's matrix alone. Tiled objects aren't chunked, their tiles are stepped along the object's own X
+// Anything that doesn't fit, or whose vertices would leave an SVECTOR's range, stays an object of its own
+static void BuildStaticChunks(size_t firstPolygon, size_t firstTexPolygon, size_t firstMultiPoly, size_t firstCollisionPolyBox) {
+    ChunkCandidate candidates[MAXCHUNKMEMBERS];
+    size_t candidateCount = 0;
+    size_t vertexCount = 0;
+
+    for (size_t i = firstPolygon; i < activePolygonCount; i++) {
+        if (activePolygons[i]->obj.isStatic) {
+            AddChunkCandidate(candidates, &candidateCount, LOT_PolyF4, activePolygons[i]);
+        }
+    }
+
+    for (size_t i = firstTexPolygon; i < activeTexPolygonCount; i++) {
+        if (activeTexPolygons[i]->polyObj.obj.isStatic) {
+            AddChunkCandidate(candidates, &candidateCount, LOT_PolyFT4, activeTexPolygons[i]);
+        }
+    }
+
+    for (size_t i = firstMultiPoly; i < activeMultiPolyCount; i++) {
+        if (activeMultiPolys[i]->obj.isStatic) {
+            AddChunkCandidate(candidates, &candidateCount, LOT_MultiPoly, activeMultiPolys[i]);
+        }
+    }
+
+    for (size_t i = firstCollisionPolyBox; i < activeCollisionPolyBoxCount; i++) {
+        AddChunkCandidate(candidates, &candidateCount, LOT_ColBox, activeCollisionPolyBoxes[i]);
+    }
+
+    for (size_t i = 0; i < candidateCount; i++) {
+        vertexCount += ChunkMemberVertexCount(&candidates[i].member);
+    }
+
+    // World space copies of the chunked objects' meshes go at the end of the level's blocks in the arena
+    SVECTOR* chunkVertices = (candidateCount > 0) ? TakeLevelMemory(vertexCount * sizeof(SVECTOR)) : NULL;
+
+    if (chunkVertices == NULL) {
+        return;
+    }
+
+    // Insertion sort, stable so members keep their level order inside a chunk
+    for (size_t i = 1; i < candidateCount; i++) {
+        ChunkCandidate candidate = candidates[i];
+        size_t j = i;
+
+        for (; j > 0 && IsChunkCandidateAfter(&candidates[j - 1], &candidate); j--) {
+            candidates[j] = candidates[j - 1];
+        }
+
+        candidates[j] = candidate;
+    }
+
+    size_t firstChunk = staticChunkCount;
+#ifdef HOST
+    size_t firstMember = chunkMemberCount;
+#endif
+    StaticChunk* chunk = NULL;
+    SVECTOR* out = chunkVertices;
+    u_long chunkKey = 0;
+
+    for (size_t i = 0; i < candidateCount; i++) {
+        ChunkCandidate* candidate = &candidates[i];
+        bool sameChunk = chunk != NULL && candidate->cell == chunk->cell && candidate->key == chunkKey;
+
+        // A chunk whose objects all failed to bake is reused for the next key
+        if (chunk == NULL || (!sameChunk && chunk->memberCount > 0)) {
+            if (staticChunkCount == MAXSTATICCHUNKS) {
+                break;
+            }
+
+            chunk = &staticChunks[staticChunkCount++];
+            chunk->firstMember = chunkMemberCount;
+            chunk->memberCount = 0;
+        }
+
+        chunkKey = candidate->key;
+        chunk->cell = candidate->cell;
+
+        if (!BakeChunkMember(&candidate->member, out)) {
+            continue;
+        }
+
+        out += ChunkMemberVertexCount(&candidate->member);
+        chunkMembers[chunkMemberCount++] = candidate->member;
+        chunk->memberCount++;
+    }
+
+    if (chunk != NULL && chunk->memberCount == 0) {
+        staticChunkCount--;
+    }
+
+    for (size_t c = firstChunk; c < staticChunkCount; c++) {
+        SetChunkBounds(&staticChunks[c]);
+    }
+
+#ifdef HOST
+    printf("Static chunks: %lu objects in %lu chunks\n", (u_long)(chunkMemberCount - firstMember), (u_long)(staticChunkCount - firstChunk));
+#endif
+}
+
+// Gives the objects from each first index on back to their pools and drops them from the active lists
+static void FreeLevelObjects(size_t firstPolygon, size_t firstTexPolygon, size_t firstTiledTexPolygon, size_t firstMultiPoly, size_t firstCollisionPolyBox) {
+    for (size_t i = firstPolygon; i < activePolygonCount; i++) {
+        PoolFree(&polyObjectPool, activePolygons[i]);
+    }
+
+    for (size_t i = firstTexPolygon; i < activeTexPolygonCount; i++) {
+        PoolFree(&texObjectPool, activeTexPolygons[i]);
+    }
+
+    for (size_t i = firstTiledTexPolygon; i < activeTiledTexPolygonCount; i++) {
+        PoolFree(&texObjectPool, activeTiledTexPolygons[i]);
+    }
+
+    for (size_t i = firstMultiPoly; i < activeMultiPolyCount; i++) {
+        PoolFree(&multiPolyPool, activeMultiPolys[i]);
+    }
+
+    for (size_t i = firstCollisionPolyBox; i < activeCollisionPolyBoxCount; i++) {
+        PoolFree(&colBoxPool, activeCollisionPolyBoxes[i]);
+    }
+
+    activePolygonCount = firstPolygon;
+    activeTexPolygonCount = firstTexPolygon;
+    activeTiledTexPolygonCount = firstTiledTexPolygon;
+    activeMultiPolyCount = firstMultiPoly;
+    activeCollisionPolyBoxCount = firstCollisionPolyBox;
+}
+
+// Builds every object of a level image in a single pass over its records, taking them from the object pools
+// and everything else they need from the level arena
+// The image has to stay in memory afterwards, as vertices, indices and primitive templates are used from it directly
+// Returns false if the level is malformed or doesn't fit, in which case nothing is added
+static bool LoadLevel(u_long* data, size_t size) {
+    const char* image = (const char*)data;
+    const LevelHeader* header = (const LevelHeader*)data;
+    LevelLoader loader = { 0 };
+    size_t objectCount = 0;
+
+    if (size < sizeof(LevelHeader) || header->magic != LEVELMAGIC || header->version != LEVELVERSION) {
+        return false;
+    }
+
+    if ((header->vertexOffset | header->indexOffset | header->materialOffset | header->objectOffset
+        | header->polyF4Offset | header->polyFT4Offset | header->lodOffset | header->cellOffset | header->portalOffset
+        | header->faceOffset | header->gridOffset) & 3) {
+        return false;
+    }
+
+    for (size_t t = 0; t < LOT_Count; t++) {
+        objectCount += header->objectCounts[t];
+    }
+
+    if (header->vertexOffset + header->vertexCount * sizeof(SVECTOR) > size
+        || header->indexOffset + header->indexCount * sizeof(u_int) > size
+        || header->materialOffset + header->materialCount * sizeof(LevelMaterial) > size
+        || header->objectOffset + objectCount * sizeof(LevelObject) > size
+        || header->polyF4Offset + header->polyF4Count * sizeof(LevelPolyF4) > size
+        || header->polyFT4Offset + header->polyFT4Count * sizeof(LevelPolyFT4) > size
+        || header->lodOffset + header->lodCount * sizeof(LevelLod) > size
+        || header->cellOffset + header->cellCount * sizeof(LevelCell) > size
+        || header->portalOffset + header->portalCount * sizeof(LevelPortal) > size
+        || header->faceOffset + header->faceCount * sizeof(u_short) > size
+        || header->gridOffset >= size) {
+        return false;
+    }
+
+    if (activePolygonCount + header->objectCounts[LOT_PolyF4] > MAXPOLYGONS
+        || activeTexPolygonCount + header->objectCounts[LOT_PolyFT4] > MAXTEXPOLYGONS
+        || activeTiledTexPolygonCount + header->objectCounts[LOT_TiledFT4] > MAXTILEDTEXPOLYGONS
+        || activeMultiPolyCount + header->objectCounts[LOT_MultiPoly] > MAXMULTIPOLYS
+        || activeCollisionPolyBoxCount + header->objectCounts[LOT_ColBox] > MAXCOLBOXES) {
+        return false;
+    }
+
+    // With every object checked for room up front, the loaders below can take theirs from the pools without looking
+    if (PoolFreeCount(&polyObjectPool) < header->objectCounts[LOT_PolyF4]
+        || PoolFreeCount(&texObjectPool) < header->objectCounts[LOT_PolyFT4] + header->objectCounts[LOT_TiledFT4]
+        || PoolFreeCount(&multiPolyPool) < header->objectCounts[LOT_MultiPoly]
+        || PoolFreeCount(&colBoxPool) < header->objectCounts[LOT_ColBox]
+        || materialPrimCount + header->materialCount > MAXMATERIALPRIMS) {
+        return false;
+    }
+
+    size_t memorySize = LEVELALIGN(header->polyFT4Count * sizeof(POLY_FT4)) // Relocated, so never used in place
+        + LEVELALIGN(header->objectCounts[LOT_ColBox] * sizeof(u_short))
+        + LEVELALIGN(2 * header->lodCount * sizeof(LodLevel)); // Objects with LODs also need a level for their full mesh
+#ifdef HOST
+    memorySize += LEVELALIGN(header->indexCount * sizeof(long))
+        + LEVELALIGN(header->polyF4Count * sizeof(POLY_F4));
+#endif
+
+    // With room for every block checked up front, the ones below can be taken without looking
+    size_t arenaMark = levelArenaUsed;
+
+    if (levelArenaUsed + memorySize > sizeof(levelArena)) {
+        return false;
+    }
+
+    // Cells only come from the first level that has any, the objects of later ones are drawn regardless of cells
+    if (header->cellCount > 0 && cellGraph.cellCount == 0) {
+        if (!CellsAttach(&cellGraph, (const LevelCell*)(image + header->cellOffset), header->cellCount,
+            (const LevelPortal*)(image + header->portalOffset), header->portalCount)) {
+            return false;
+        }
+
+        loader.usesCells = true;
+    }
+
+    loader.header = header;
+    loader.vertices = (SVECTOR*)(image + header->vertexOffset);
+    loader.materials = (const LevelMaterial*)(image + header->materialOffset);
+    loader.faces = (const u_short*)(image + header->faceOffset);
+    loader.polyFT4s = TakeLevelMemory(header->polyFT4Count * sizeof(POLY_FT4)); // First, see CheckLevelReload()
+    u_short* boxStamps = TakeLevelMemory(header->objectCounts[LOT_ColBox] * sizeof(u_short));
+    loader.nextLodLevel = TakeLevelMemory(2 * header->lodCount * sizeof(LodLevel));
+    loader.lods = (const LevelLod*)(image + header->lodOffset);
+#ifdef HOST
+    loader.indices = TakeLevelMemory(header->indexCount * sizeof(long));
+    loader.polyF4s = TakeLevelMemory(header->polyF4Count * sizeof(POLY_F4));
+    ConvertLevelPrims(&loader, image);
+#else
+    loader.indices = (long*)(image + header->indexOffset);
+    loader.polyF4s = (POLY_F4*)(image + header->polyF4Offset);
+    memcpy(loader.polyFT4s, image + header->polyFT4Offset, header->polyFT4Count * sizeof(POLY_FT4));
+#endif
+
+    LoadMaterialPrims(&loader);
+
+    size_t firstPolygon = activePolygonCount;
+    size_t firstTexPolygon = activeTexPolygonCount;
+    size_t firstTiledTexPolygon = activeTiledTexPolygonCount;
+    size_t firstMultiPoly = activeMultiPolyCount;
+    size_t firstCollisionPolyBox = activeCollisionPolyBoxCount;
+    const LevelObject* lobj = (const LevelObject*)(image + header->objectOffset);
+
+    for (size_t i = 0; i < objectCount; i++, lobj++) {
+        if (!IsLevelObjectValid(&loader, lobj)) {
+            FreeLevelObjects(firstPolygon, firstTexPolygon, firstTiledTexPolygon, firstMultiPoly, firstCollisionPolyBox);
+            materialPrimCount = loader.firstMaterialPrim;
+            levelArenaUsed = arenaMark;
+
+            if (loader.usesCells) {
+                CellsClear(&cellGraph);
+            }
+
+            return false;
+        }
+
+        switch (lobj->type) {
+            case LOT_PolyF4:
+                LoadPolyF4Object(&loader, lobj);
+                break;
+            case LOT_PolyFT4:
+            case LOT_TiledFT4:
+                LoadTexturedObject(&loader, lobj);
+                break;
+            case LOT_MultiPoly:
+                LoadMultiPoly(&loader, lobj);
+                break;
+            case LOT_ColBox:
+                LoadCollisionPolyBox(&loader, lobj);
+                break;
+        }
+
+        loader.loaded[lobj->type]++;
+    }
+
+    LoadCollisionGrid(image, size, firstCollisionPolyBox, boxStamps);
+    BuildStaticChunks(firstPolygon, firstTexPolygon, firstMultiPoly, firstCollisionPolyBox);
+
+    return true;
+}
+
+// Drops everything the loaded levels added, leaving only the player. The level images themselves aren't touched
+void UnloadLevels() {
+    activePolygonCount = 0;
+    activeTexPolygonCount = 0;
+    activeTiledTexPolygonCount = 0;
+    activeMultiPolyCount = 0;
+    activeCollisionPolyBoxCount = 0;
+    PoolReset(&polyObjectPool);
+    PoolReset(&texObjectPool);
+    PoolReset(&multiPolyPool);
+    PoolReset(&colBoxPool);
+
+    if (player != NULL) {
+        activePolygons[activePolygonCount++] = &player->poly;
+    }
+
+    staticChunkCount = 0;
+    chunkMemberCount = 0;
+    materialPrimCount = 0;
+    levelArenaUsed = 0;
+
+    ColGridFree(&collisionGrid);
+    CellsClear(&cellGraph);
+}
+
+// Pool usage, peaks included, and level arena usage, for sizing their capacities
+void PrintPools() {
+    PoolPrint(&polyObjectPool);
+    PoolPrint(&texObjectPool);
+    PoolPrint(&multiPolyPool);
+    PoolPrint(&colBoxPool);
+    printf("%-16s %5lu of %d bytes used\n", "levelArena", (u_long)levelArenaUsed, LEVELARENASIZE);
+}
+
+#ifdef HOST
+// Loads a level twice with every texture moved inside its page and checks both loads relocate its templates the same
+// A load that relocated them inside the image would move them a second time on the reload
+// Loaded into an empty arena, the level's textured templates are the first block of it
+static bool CheckLevelReload(u_long* data, size_t size) {
+    static POLY_FT4 firstLoad[LEVELARENASIZE / sizeof(POLY_FT4)];
+    const LevelHeader* header = (const LevelHeader*)data;
+    size_t templateSize = header->polyFT4Count * sizeof(POLY_FT4);
+    TexturePlacement placements[TEX_Count];
+    bool same;
+
+    memcpy(placements, texturePlacements, sizeof(placements));
+
+    for (size_t i = 0; i < TEX_Count; i++) {
+        texturePlacements[i].du += 8;
+        texturePlacements[i].dv += 8;
+    }
+
+    UnloadLevels();
+    same = LoadLevel(data, size);
+
+    if (same) {
+        memcpy(firstLoad, levelArena, templateSize);
+        UnloadLevels();
+        same = LoadLevel(data, size) && memcmp(firstLoad, levelArena, templateSize) == 0;
+    }
+
+    memcpy(texturePlacements, placements, sizeof(placements));
+
+    return same;
+}
+#endif
+
+// There is only ever the one player, so it lives in static storage rather than a pool
+void CreatePlayer(CVECTOR* col) {
+    player = &playerObject;
+
+    CameraObject* camera = &playerCamera;
+    POLY_F4* pplayer = playerPolys;
+    VECTOR pos = { 0, 0, 0, 0 };
+
+    memset(player, 0, sizeof(PlayerObject));
+    memset(camera, 0, sizeof(CameraObject));
+
+    setVector(&player->poly.obj.position, pos.vx * ONE, pos.vy * ONE, pos.vz * ONE);
+    player->poly.polyLength = 6;
+    player->poly.polySides = 4;
+    player->poly.verticesPtr = playerBoxVertices;
+    player->poly.indicesPtr = cubeIndices;
+    player->poly.polyPtr = pplayer;
+    player->poly.drPrio = DRP_Neutral;
+    player->poly.collides = false;
+    player->poly.boxHeight = PLAYERHEIGHT;
+    player->poly.boxWidth = PLAYERWIDTHHALF * 2;
+    player->poly.obj.maxSpeed = 5 * ONE;
+    player->poly.obj.isStatic = false;
+    player->poly.obj.cell = LEVELNOCELL;
+    //player->poly.add = &AddPolyF;
+
+    player->cameraPtr = camera;
+
+    for (size_t i = 0; i < 6; ++i) {
+        SetPolyF4(&pplayer[i]);
+        setRGB0(&pplayer[i], col[i].r, col[i].g, col[i].b);
+    }
+
+    RotMatrix_gte(&player->poly.obj.rotation, &player->poly.obj.transform);
+    TransMatrix(&player->poly.obj.transform, &pos);
+    player->poly.obj.transformRotation = player->poly.obj.rotation;
+    SetBoundsFromIndices(&player->poly.bounds, playerBoxVertices, cubeIndices, 24, &player->poly.obj.transform);
+}
+
+// Update poly matrix
+static void UpdatePolyObject(PolyObject* pobj) {
+    // If object can move in any way, apply velocity
+    if (!pobj->obj.isStatic) {
+        /*
+        if (GetVectorPlaneLength64(&pobj->obj.velocity) > (pobj->obj.maxSpeed << 6)) {
+            VECTOR appliedVelocity = { 0 };
+
+            VectorNormal(&pobj->obj.velocity, &appliedVelocity);
+            appliedVelocity.vx *= pobj->obj.maxSpeed * ONE;
+            appliedVelocity.vz *= pobj->obj.maxSpeed * ONE;
+
+            addVector(&pobj->obj.position, &appliedVelocity);
+        }
+        else {
+            addVector(&pobj->obj.position, &pobj->obj.velocity);
+        }
+        */
+        
+        VECTOR gridPos = { 
+            pobj->obj.position.vx >> 12, 
+            pobj->obj.position.vy >> 12, 
+            pobj->obj.position.vz >> 12, 0
+        };
+
+        MATRIX* transform = &pobj->obj.transform;
+        SVECTOR* rotation = &pobj->obj.rotation;
+
+        // Nothing to rebuild for objects that didn't move or turn, which keeps their composed transform valid too
+        if (gridPos.vx == transform->t[0] && gridPos.vy == transform->t[1] && gridPos.vz == transform->t[2]
+            && rotation->vx == pobj->obj.transformRotation.vx && rotation->vy == pobj->obj.transformRotation.vy
+            && rotation->vz == pobj->obj.transformRotation.vz) {
+            return;
+        }
+
+        RotMatrix_gte(rotation, transform);
+        TransMatrix(transform, &gridPos);
+        UpdateBoundsWorldCentre(&pobj->bounds, transform);
+
+        pobj->obj.transformRotation = *rotation;
+        pobj->obj.transformStamp++;
+    }
+}
+
+// Cheap whole-object test, run before any matrix composition or face transforms
+// Returns false if the sphere is fully behind the camera, too far away, or outside one of the four side planes
+static bool IsObjectVisible(CameraObject* camera, BoundingSphere* bounds) {
+    VECTOR view;
+    long r = bounds->radius;
+
+    ApplyMatrixLV(&camera->transform, &bounds->worldCentre, &view);
+    view.vx += camera->transform.t[0];
+    view.vy += camera->transform.t[1];
+    view.vz += camera->transform.t[2];
+    bounds->viewDepth = view.vz;
+
+    if (view.vz + r < CULLNEARDISTANCE || view.vz - r > CULLFARDISTANCE) {
+        return false;
+    }
+
+    // Projection plane distance is RENDERX / 2, so the side planes are at x = +-z (90 degrees horizontally)
+    // Distance to them is (|x| - z) / sqrt(2), compared against the radius without the division
+    if (abs(view.vx) - view.vz > ((r * 1448) >> 10)) {
+        return false;
+    }
+
+    // Top and bottom planes are at y = +-z * 3/4, with a normal of length 5/4
+    if ((abs(view.vy) * 4) - (view.vz * 3) > r * 5) {
+        return false;
+    }
+
+    return true;
+}
+
+// Culls an object and updates the drawn/culled counters
+static bool CullObject(CameraObject* camera, BoundingSphere* bounds) {
+    if (IsObjectVisible(camera, bounds)) {
+        ProfilerCount(PRC_Drawn, 1);
+        return false;
+    }
+
+    ProfilerCount(PRC_Culled, 1);
+    return true;
+}
+
+// Skips count objects of a cell the camera can't see into this frame, before any frustum test
+static bool IsCellHidden(u_char cell, u_short count) {
+    if (CellsIsVisible(&cellGraph, cell)) {
+        return false;
+    }
+
+    ProfilerCount(PRC_Hidden, count);
+    return true;
+}
+
+// Index of the LOD to draw at camera space depth. Only moves off lod once depth is LODHYSTERESIS past a switch distance
+static u_char SelectLod(const LodLevel* lods, u_char lodCount, u_char lod, long depth) {
+    while (lod + 1 < lodCount && depth > lods[lod + 1].distance + LODHYSTERESIS) {
+        lod++;
+    }
+
+    while (lod > 0 && depth < lods[lod].distance - LODHYSTERESIS) {
+        lod--;
+    }
+
+    return lod;
+}
+
+// Switches an object over to the mesh for its depth as of the last CullObject()
+static void UpdatePolyObjectLod(PolyObject* pobj) {
+    if (pobj->lods == NULL) {
+        return;
+    }
+
+    u_char lod = SelectLod(pobj->lods, pobj->lodCount, pobj->lod, pobj->bounds.viewDepth);
+
+    if (lod == pobj->lod) {
+        return;
+    }
+
+    const LodLevel* level = &pobj->lods[lod];
+
+    pobj->lod = lod;
+    pobj->polyPtr = level->polyPtr;
+    pobj->verticesPtr = level->verticesPtr;
+    pobj->indicesPtr = level->indicesPtr;
+    pobj->polyLength = level->polyLength;
+    pobj->vertexCount = level->vertexCount;
+    pobj->batchTransform = level->batchTransform;
+}
+
+// Loads the GTE with matrix composed with the camera's transform
+// The result is kept in render and only composed again once the camera or the object (objectStamp) has changed,
+// so static objects under a still camera skip the matrix multiply entirely
+static void CameraTransformMatrix(CameraObject* camera, MATRIX* matrix, u_long objectStamp, RenderTransform* render) {
+    if (render->cameraStamp != camera->transformStamp || render->objectStamp != objectStamp) {
+        gte_CompMatrix(&camera->transform, matrix, &render->transform);
+        render->cameraStamp = camera->transformStamp;
+        render->objectStamp = objectStamp;
+        ProfilerCount(PRC_Composed, 1);
+    }
+
+    gte_SetRotMatrix(&render->transform);
+    gte_SetTransMatrix(&render->transform);
+}
+
+// Transforms count vertices once each with batched RTPT, filling meshSXY and meshSZ in the same order
+// Meshes can then build all their faces from the cache, instead of transforming shared corners once per face
+static void TransformMeshVertices(const SVECTOR* vertices, size_t count) {
+    if (scratchMeshSXY != NULL && count <= SCRATCHMESHSIZE) {
+        meshSXY = scratchMeshSXY;
+        meshSZ = scratchMeshSZ;
+    }
+    else {
+        meshSXY = mainMeshSXY;
+        meshSZ = mainMeshSZ;
+    }
+
+    // Batches of 3, the last batch repeats the final vertex instead of reading past the mesh
+    for (size_t v = 0; v < count; v += 3) {
+        size_t v1 = (v + 1 < count) ? v + 1 : count - 1;
+        size_t v2 = (v + 2 < count) ? v + 2 : count - 1;
+
+        gte_ldv3(&vertices[v], &vertices[v1], &vertices[v2]);
+        gte_rtpt();
+        gte_stsxy3(&meshSXY[v], &meshSXY[v + 1], &meshSXY[v + 2]);
+        gte_stsz3(&meshSZ[v], &meshSZ[v + 1], &meshSZ[v + 2]);
+    }
+}
+
+// NCLIP and average depth of a quad whose corners are in the screen cache
+// Returns the layer's OT entry to add it at, or NULL if it faces away or falls outside of the OT, same as the RotAverageNclip4() paths
+static u_long* CachedQuadOTEntry(size_t c0, size_t c1, size_t c2, size_t c3, enum OTLayer layer) {
+    long nclip;
+
+    gte_ldsxy3(meshSXY[c0], meshSXY[c1], meshSXY[c2]);
+    gte_nclip();
+    gte_stopz(&nclip);
+
+    if (nclip <= 0) {
+        return NULL;
+    }
+
+    return OTEntry(layer, AverageZ4(meshSZ[c0], meshSZ[c1], meshSZ[c2], meshSZ[c3]));
+}
+
+static void AddPolyF(PolyObject* pobj) {
+    long otz;
+    int nclip;
+
+    if (pobj->polySides == 4 && pobj->batchTransform) {
+        POLY_F4* tmpl = (POLY_F4*)pobj->polyPtr;
+
+        TransformMeshVertices(pobj->verticesPtr, pobj->vertexCount);
+
+        for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++tmpl) {
+            const long* face = &pobj->indicesPtr[i];
+
+            u_long* entry = CachedQuadOTEntry(face[0], face[1], face[2], face[3], priorityLayers[pobj->drPrio]);
+
+            if (entry == NULL) {
+                continue;
+            }
+
+            POLY_F4* poly = CopyPrim(tmpl, sizeof(POLY_F4));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            setCachedXY4(poly, face[0], face[1], face[2], face[3]);
+            AddPrim(entry, poly);
+            CommitPrim(sizeof(POLY_F4));
+        }
+    }
+    else if (pobj->polySides == 4) {
+        POLY_F4* tmpl = (POLY_F4*)pobj->polyPtr;
+
+        for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++tmpl) {
+            POLY_F4* poly = CopyPrim(tmpl, sizeof(POLY_F4));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            // Non-Average version (RotNclip4) presents layering issues, at least tested on floor against Average cube
+            nclip = RotAverageNclip4(
+                &pobj->verticesPtr[pobj->indicesPtr[i + 0]], &pobj->verticesPtr[pobj->indicesPtr[i + 1]],
+                &pobj->verticesPtr[pobj->indicesPtr[i + 2]], &pobj->verticesPtr[pobj->indicesPtr[i + 3]],
+                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &drawTemps->p, &otz, &drawTemps->flg
+            );
+
+            if (nclip <= 0) {
+                continue;
+            }
+            
+            u_long* entry = OTEntry(priorityLayers[pobj->drPrio], otz);
+
+            if (entry != NULL) {
+                AddPrim(entry, poly);
+                CommitPrim(sizeof(POLY_F4));
+            }
+        }
+    }
+    else if (pobj->polySides == 3) {
+        POLY_F3* tmpl = (POLY_F3*)pobj->polyPtr;
+
+        for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++tmpl) {
+            POLY_F3* poly = CopyPrim(tmpl, sizeof(POLY_F3));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            nclip = RotAverageNclip3(
+                &pobj->verticesPtr[pobj->indicesPtr[i + 0]], &pobj->verticesPtr[pobj->indicesPtr[i + 1]],
+                &pobj->verticesPtr[pobj->indicesPtr[i + 2]],
+                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x2, &drawTemps->p, &otz, &drawTemps->flg
+            );
+
+            if (nclip <= 0) {
+                continue;
+            }
+
+            u_long* entry = OTEntry(priorityLayers[pobj->drPrio], otz);
+
+            if (entry != NULL) {
+                AddPrim(entry, poly);
+                CommitPrim(sizeof(POLY_F3));
+            }
+        }
+    }
+}
+
+// A texture window DR_MODE pair in one OT entry. Faces of an object that land in the same entry are linked in between
+// the two, so a run of them costs one window change (and one change back) instead of one per face
+typedef struct WindowRun {
+    u_long* entry;
+    DR_MODE* mode;
+} WindowRun;
+
+// Links prim into entry with the object's texture window on, starting a new run if the last one was in another entry
+// Returns false without linking anything once the frame is out of DR_MODEs
+static bool AddWindowedPrim(TexturedPolyObject* tpobj, WindowRun* run, u_long* entry, void* prim, u_short tpage) {
+    if (run->entry != entry) {
+        DR_MODE* modes = AllocDrModes(2);
+
+        if (modes == NULL) {
+            return false;
+        }
+
+        // Entries are lists built front to back, so the window goes on last to end up ahead of the faces and its reset
+        setDrawMode(&modes[0], 0, 1, tpage, &tpobj->trect);
+        setDrawMode(&modes[1], 0, 1, tpage, NULL);
+        AddPrim(entry, &modes[1]);
+        AddPrim(entry, &modes[0]);
+
+        run->entry = entry;
+        run->mode = &modes[0];
+    }
+
+    AddPrim(run->mode, prim);
+
+    return true;
+}
+
+// Links one of a textured object's prims into entry, inside a texture window run if the object needs one
+// Out of DR_MODEs, the prim is still drawn without the window, which only shows on UVs past it
+static void AddTexturedPrim(TexturedPolyObject* tpobj, WindowRun* run, u_long* entry, void* prim, u_short tpage) {
+    if (!tpobj->windowed || !AddWindowedPrim(tpobj, run, entry, prim, tpage)) {
+        AddPrimByTPage(entry, prim);
+    }
+}
+
+// Corner of a subdivided face, in camera space with its texture coordinates
+typedef struct ClipVertex {
+    long x;
+    long y;
+    long z;
+    long u;
+    long v;
+    long sxy; // Projected position, packed like the GTE's SXY
+} ClipVertex;
+
+// Bilinear blend of a face's corner values at lattice point (column, row) of an n by n split
+// c0 is at (0, 0), c1 at (n, 0), c2 at (n, n) and c3 at (0, n), same as the face's corner order
+static long FaceLerp(long c0, long c1, long c2, long c3, long n, long column, long row) {
+    return (((c0 * (n - column)) + (c1 * column)) * (n - row) + ((c3 * (n - column)) + (c2 * column)) * row) / (n * n);
+}
+
+// Point where the edge from a (in front of the near plane) to b (behind it) crosses the near plane, projected like the GTE does
+static void ClipEdge(const ClipVertex* a, const ClipVertex* b, ClipVertex* out) {
+    long num = NEARCLIPDISTANCE - a->z;
+    long den = b->z - a->z;
+    long sx, sy;
+
+    out->x = a->x + ((b->x - a->x) * num) / den;
+    out->y = a->y + ((b->y - a->y) * num) / den;
+    out->z = NEARCLIPDISTANCE;
+    out->u = a->u + ((b->u - a->u) * num) / den;
+    out->v = a->v + ((b->v - a->v) * num) / den;
+
+    // Same offset and projection distance as set up in InitGraphics()
+    sx = (RENDERX / 2) + ((out->x * (RENDERX / 2)) / NEARCLIPDISTANCE);
+    sy = (RENDERY / 2) + ((out->y * (RENDERX / 2)) / NEARCLIPDISTANCE);
+    sx = (sx < -1024) ? -1024 : (sx > 1023) ? 1023 : sx;
+    sy = (sy < -1024) ? -1024 : (sy > 1023) ? 1023 : sy;
+    out->sxy = (sx & 0xFFFF) | (sy << 16);
+}
+
+// Cuts a quad that crosses the near plane down to the part in front of it and adds that as an FT4, FT3, or both
+// Corners in front of the plane keep their screen positions from the cache, so the cut face lines up with its neighbours
+static void AddClippedQuad(TexturedPolyObject* tpobj, WindowRun* run, POLY_FT4* tmpl, ClipVertex* quad) {
+    ClipVertex clipped[5];
+    size_t count = 0;
+    long area = 0;
+    long otz = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        ClipVertex* a = &quad[i];
+        ClipVertex* b = &quad[(i + 1) & 3];
+        bool aInFront = a->z >= NEARCLIPDISTANCE;
+        bool bInFront = b->z >= NEARCLIPDISTANCE;
+
+        if (aInFront) {
+            clipped[count++] = *a;
+        }
+
+        if (aInFront != bInFront) {
+            ClipEdge(aInFront ? a : b, aInFront ? b : a, &clipped[count++]);
+        }
+    }
+
+    // Facing is taken from the whole outline, with the same sign as NCLIP, and depth is averaged the same way as AverageZ4()
+    for (size_t i = 0; i < count; i++) {
+        long next = clipped[(i + 1) % count].sxy;
+
+        area += (SXYX(clipped[i].sxy) * SXYY(next)) - (SXYX(next) * SXYY(clipped[i].sxy));
+        otz += clipped[i].z;
+    }
+
+    u_long* entry = OTEntry(priorityLayers[tpobj->polyObj.drPrio], otz / (4 * (long)count));
+
+    if (area <= 0 || entry == NULL) {
+        return;
+    }
+
+    ProfilerCount(PRC_Clipped, 1);
+
+    if (count >= 4) {
+        POLY_FT4* poly = CopyPrim(tmpl, sizeof(POLY_FT4));
+
+        if (poly == NULL) {
+            return;
+        }
+
+        setXY4(poly, SXYX(clipped[0].sxy), SXYY(clipped[0].sxy), SXYX(clipped[1].sxy), SXYY(clipped[1].sxy),
+            SXYX(clipped[3].sxy), SXYY(clipped[3].sxy), SXYX(clipped[2].sxy), SXYY(clipped[2].sxy));
+        setUV4(poly, clipped[0].u, clipped[0].v, clipped[1].u, clipped[1].v, clipped[3].u, clipped[3].v, clipped[2].u, clipped[2].v);
+        AddTexturedPrim(tpobj, run, entry, poly, tmpl->tpage);
+        CommitPrim(sizeof(POLY_FT4));
+    }
+
+    // A triangle, or the corner left over from a pentagon
+    if (count != 4) {
+        ClipVertex* c0 = &clipped[0];
+        ClipVertex* c1 = &clipped[count - 2];
+        ClipVertex* c2 = &clipped[count - 1];
+
+        // The first 8 words of an FT4 are an FT3 once the quad bit is cleared
+        POLY_FT3* poly = CopyPrim(tmpl, sizeof(POLY_FT3));
+
+        if (poly == NULL) {
+            return;
+        }
+
+        setlen(poly, 7);
+        setcode(poly, getcode(tmpl) & ~0x08);
+        setXY3(poly, SXYX(c0->sxy), SXYY(c0->sxy), SXYX(c1->sxy), SXYY(c1->sxy), SXYX(c2->sxy), SXYY(c2->sxy));
+        setUV3(poly, c0->u, c0->v, c1->u, c1->v, c2->u, c2->v);
+        AddTexturedPrim(tpobj, run, entry, poly, tmpl->tpage);
+        CommitPrim(sizeof(POLY_FT3));
+    }
+}
+
+// Draws each face of a textured object split into 1x1, 2x2 or 4x4 smaller faces, depending on how near its nearest corner is
+// This keeps the affine texture warping of big faces down up close, without splitting them while they're far away
+// Split faces that cross the near plane are clipped against it, instead of being dropped like the RotAverageNclip4() paths do
+static void AddSubdividedPolyFT(TexturedPolyObject* tpobj) {
+    PolyObject* pobj = &tpobj->polyObj;
+    POLY_FT4* tmpl = (POLY_FT4*)pobj->polyPtr;
+    SVECTOR lattice[(MAXSUBDIVS + 1) * (MAXSUBDIVS + 1)];
+    VECTOR view[4];
+    WindowRun run = { NULL, NULL };
+    long flg;
+
+    for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++tmpl) {
+        const long* face = &pobj->indicesPtr[i];
+        const SVECTOR* c[4] = {
+            &pobj->verticesPtr[face[0]], &pobj->verticesPtr[face[1]], &pobj->verticesPtr[face[2]], &pobj->verticesPtr[face[3]]
+        };
+        // The primitive's 3rd and 4th corners are swapped, see setCachedXY4()
+        long u[4] = { tmpl->u0, tmpl->u1, tmpl->u3, tmpl->u2 };
+        long v[4] = { tmpl->v0, tmpl->v1, tmpl->v3, tmpl->v2 };
+        long nearest = 0x7FFFFFFF;
+        long furthest = -0x7FFFFFFF;
+
+        for (size_t k = 0; k < 4; k++) {
+            RotTrans((SVECTOR*)c[k], &view[k], &flg);
+            nearest = (view[k].vz < nearest) ? view[k].vz : nearest;
+            furthest = (view[k].vz > furthest) ? view[k].vz : furthest;
+        }
+
+        if (furthest < NEARCLIPDISTANCE) {
+            continue;
+        }
+
+        long n = (nearest < SUBDIVIDE4DISTANCE) ? 4 : (nearest < SUBDIVIDE2DISTANCE) ? 2 : 1;
+        long columns = n + 1;
+
+        for (long row = 0; row <= n; row++) {
+            for (long column = 0; column <= n; column++) {
+                setVector(&lattice[(row * columns) + column],
+                    FaceLerp(c[0]->vx, c[1]->vx, c[2]->vx, c[3]->vx, n, column, row),
+                    FaceLerp(c[0]->vy, c[1]->vy, c[2]->vy, c[3]->vy, n, column, row),
+                    FaceLerp(c[0]->vz, c[1]->vz, c[2]->vz, c[3]->vz, n, column, row));
+            }
+        }
+
+        TransformMeshVertices(lattice, columns * columns);
+
+        for (long row = 0; row < n; row++) {
+            for (long column = 0; column < n; column++) {
+                // Lattice corners of this part, in the face's own corner order
+                long px[4] = { column, column + 1, column + 1, column };
+                long py[4] = { row, row, row + 1, row + 1 };
+                size_t lc[4];
+                ClipVertex quad[4];
+                size_t inFront = 0;
+
+                for (size_t k = 0; k < 4; k++) {
+                    lc[k] = (py[k] * columns) + px[k];
+                    quad[k].z = FaceLerp(view[0].vz, view[1].vz, view[2].vz, view[3].vz, n, px[k], py[k]);
+                    quad[k].u = FaceLerp(u[0], u[1], u[2], u[3], n, px[k], py[k]);
+                    quad[k].v = FaceLerp(v[0], v[1], v[2], v[3], n, px[k], py[k]);
+                    inFront += quad[k].z >= NEARCLIPDISTANCE;
+                }
+
+                if (inFront == 0) {
+                    continue;
+                }
+
+                if (inFront < 4) {
+                    for (size_t k = 0; k < 4; k++) {
+                        quad[k].x = FaceLerp(view[0].vx, view[1].vx, view[2].vx, view[3].vx, n, px[k], py[k]);
+                        quad[k].y = FaceLerp(view[0].vy, view[1].vy, view[2].vy, view[3].vy, n, px[k], py[k]);
+                        quad[k].sxy = meshSXY[lc[k]];
+                    }
+
+                    AddClippedQuad(tpobj, &run, tmpl, quad);
+                    continue;
+                }
+
+                u_long* entry = CachedQuadOTEntry(lc[0], lc[1], lc[2], lc[3], priorityLayers[pobj->drPrio]);
+
+                if (entry == NULL) {
+                    continue;
+                }
+
+                POLY_FT4* poly = CopyPrim(tmpl, sizeof(POLY_FT4));
+
+                if (poly == NULL) {
+                    return;
+                }
+
+                setCachedXY4(poly, lc[0], lc[1], lc[2], lc[3]);
+                setUV4(poly, quad[0].u, quad[0].v, quad[1].u, quad[1].v, quad[3].u, quad[3].v, quad[2].u, quad[2].v);
+                AddTexturedPrim(tpobj, &run, entry, poly, tmpl->tpage);
+                CommitPrim(sizeof(POLY_FT4));
+            }
+        }
+    }
+}
+
+//static void AddPolyFT(PolyObject* pobj, DR_TPAGE* tpage, u_long* ot) {
+static void AddPolyFT(TexturedPolyObject* tpobj) {
+    long otz;
+    int nclip;
+    WindowRun run = { NULL, NULL };
+
+    if (tpobj->subdivides && tpobj->polyObj.lod == 0) {
+        AddSubdividedPolyFT(tpobj);
+    }
+    else if (tpobj->polyObj.polySides == 4 && tpobj->polyObj.batchTransform) {
+        PolyObject* pobj = &tpobj->polyObj;
+        POLY_FT4* tmpl = (POLY_FT4*)pobj->polyPtr;
+
+        TransformMeshVertices(pobj->verticesPtr, pobj->vertexCount);
+
+        for (size_t i = 0; i < (pobj->polyLength * pobj->polySides); i += pobj->polySides, ++tmpl) {
+            const long* face = &pobj->indicesPtr[i];
+
+            u_long* entry = CachedQuadOTEntry(face[0], face[1], face[2], face[3], priorityLayers[pobj->drPrio]);
+
+            if (entry == NULL) {
+                continue;
+            }
+
+            POLY_FT4* poly = CopyPrim(tmpl, sizeof(POLY_FT4));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            setCachedXY4(poly, face[0], face[1], face[2], face[3]);
+            AddTexturedPrim(tpobj, &run, entry, poly, tmpl->tpage);
+            CommitPrim(sizeof(POLY_FT4));
+        }
+    }
+    else if (tpobj->polyObj.polySides == 4) {
+        POLY_FT4* tmpl = (POLY_FT4*)tpobj->polyObj.polyPtr;
+
+        for (size_t i = 0; i < (tpobj->polyObj.polyLength * tpobj->polyObj.polySides); i += tpobj->polyObj.polySides, ++tmpl) {
+            POLY_FT4* poly = CopyPrim(tmpl, sizeof(POLY_FT4));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            // Non-Average version (RotNclip4) presents layering issues, at least tested on floor against Average cube
+            nclip = RotAverageNclip4(
+                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 0]], &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 1]],
+                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 2]], &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 3]],
+                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &drawTemps->p, &otz, &drawTemps->flg
+            );
+
+            if (nclip <= 0) {
+                continue;
+            }
+            
+            u_long* entry = OTEntry(priorityLayers[tpobj->polyObj.drPrio], otz);
+
+            if (entry != NULL) {
+                AddTexturedPrim(tpobj, &run, entry, poly, tmpl->tpage);
+                CommitPrim(sizeof(POLY_FT4));
+            }
+        }
+    }
+    else if (tpobj->polyObj.polySides == 3) {
+        POLY_FT3* tmpl = (POLY_FT3*)tpobj->polyObj.polyPtr;
+
+        for (size_t i = 0; i < (tpobj->polyObj.polyLength * tpobj->polyObj.polySides); i += tpobj->polyObj.polySides, ++tmpl) {
+            POLY_FT3* poly = CopyPrim(tmpl, sizeof(POLY_FT3));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            nclip = RotAverageNclip3(
+                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 0]], &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 1]],
+                &tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[i + 2]],
+                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x2, &drawTemps->p, &otz, &drawTemps->flg
+            );
+
+            if (nclip <= 0) {
+                continue;
+            }
+
+            u_long* entry = OTEntry(priorityLayers[tpobj->polyObj.drPrio], otz);
+
+            if (entry != NULL) {
+                AddTexturedPrim(tpobj, &run, entry, poly, tmpl->tpage);
+                CommitPrim(sizeof(POLY_FT3));
+            }
+        }
+    }
+}
 
 // Tiles polys side by side
-static void AddTiledPolyFT(TexturedPolyObject* tpobj, u_long* ot) {
-    long p, otz, flg;
+// With the texture window on, runs of up to windowTiles tiles are drawn as one stretched face whose UVs wrap in it
+// Out of DR_MODEs, the rest of the tiles go back to one face each
+static void AddTiledPolyFT(TexturedPolyObject* tpobj) {
+    long otz;
     int nclip;
+    WindowRun run = { NULL, NULL };
 
     if (tpobj->polyObj.polySides == 4) {
-        POLY_FT4* poly = (POLY_FT4*)tpobj->polyObj.polyPtr;
+        POLY_FT4* tmpl = (POLY_FT4*)tpobj->polyObj.polyPtr;
+        size_t tiles = tpobj->polyObj.polyLength;
+        size_t runLength = tpobj->windowTiles;
+        size_t count;
+
+        for (size_t tile = 0; tile < tiles; tile += count, tmpl += count) {
+            SVECTOR* modVertices = drawTemps->tileVertices;
+            POLY_FT4* poly = CopyPrim(tmpl, sizeof(POLY_FT4));
+            u_char uMin = 255;
+
+            if (poly == NULL) {
+                break;
+            }
+
+            // Template UVs in face corner order, the primitive's 3rd and 4th corners are swapped
+            u_char* u[4] = { &poly->u0, &poly->u1, &poly->u3, &poly->u2 };
+            count = (tiles - tile < runLength) ? tiles - tile : runLength;
+
+            for (size_t v = 0; v < 4; v++) {
+                uMin = (*u[v] < uMin) ? *u[v] : uMin;
+            }
 
-        for (size_t i = 0; i < (tpobj->polyObj.polyLength * tpobj->polyObj.polySides); i += tpobj->polyObj.polySides, ++poly) {
-            SVECTOR modVertices[4];
-            
             for (size_t v = 0; v < 4; v++) {
                 modVertices[v] = tpobj->polyObj.verticesPtr[tpobj->polyObj.indicesPtr[v]];
-                modVertices[v].vx += 64 * (i / tpobj->polyObj.polySides); // 64 is length of wall segment. Magic value will be removed later
+                modVertices[v].vx += TILEDSEGMENTLENGTH * tile;
+
+                // Corners on the far side of the tile move to the end of the run, and their U past the window's edge
+                if (*u[v] != uMin) {
+                    modVertices[v].vx += TILEDSEGMENTLENGTH * (count - 1);
+                    *u[v] += tpobj->trect.w * (count - 1);
+                }
             }
 
             nclip = RotAverageNclip4(
                 &modVertices[0], &modVertices[1],
                 &modVertices[2], &modVertices[3],
-                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &p, &otz, &flg
+                (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &drawTemps->p, &otz, &drawTemps->flg
             );
             
             if (nclip <= 0) {
                 continue;
             }
             
-            if ((otz > 0) && (otz < OTSIZE)) {
-                OrderThing(&otz, tpobj->polyObj.drPrio);
-                AddPrim(&ot[otz], poly);
+            u_long* entry = OTEntry(priorityLayers[tpobj->polyObj.drPrio], otz);
+
+            if (entry == NULL) {
+                continue;
             }
+
+            if (count == 1) {
+                AddPrimByTPage(entry, poly);
+            }
+            else if (!AddWindowedPrim(tpobj, &run, entry, poly, poly->tpage)) {
+                runLength = 1;
+                count = 0;
+                continue;
+            }
+
+            CommitPrim(sizeof(POLY_FT4));
         }
     }
 }
 
-// Tiles polys side by side
-static void AddMultiPoly(TestTileMultiPoly* tmp, u_long* ot) {
-    long p, otz, flg;
-    int nclip;
+// Draws the faces of a multi poly from its lattice, which goes through the screen cache once per frame
+static void AddMultiPoly(TestTileMultiPoly* tmp) {
+    POLY_FT4* tmpl = tmp->polyPtr;
+    const long* corners = tmp->indicesPtr;
 
-    POLY_FT4* poly = (POLY_FT4*)tmp->polyPtr;
+    size_t columns = (tmp->repeats * tmp->subdivs) + 1;
 
-    u_char vertX = 0;
-    u_char vertY = 0;
-    u_char vertYinv = tmp->subdivs - 1;
+    TransformMeshVertices(tmp->verticesPtr, columns * (tmp->subdivs + 1));
 
-    u_char sw = tmp->width / tmp->subdivs;
-    u_char sh = tmp->height / tmp->subdivs;
-    u_char sd = tmp->depth / tmp->subdivs;
+    // Templates start at the top row, or the far row for floors
+    for (size_t row = tmp->subdivs; row-- > 0;) {
+        for (size_t column = 0; column < columns - 1; ++column, ++tmpl) {
+            size_t base = (row * columns) + column;
+            size_t c0 = base + corners[0];
+            size_t c1 = base + corners[1];
+            size_t c2 = base + corners[2];
+            size_t c3 = base + corners[3];
 
-    for (size_t i = 0; i < tmp->totalPolys; ++i, ++poly) {
-        SVECTOR modVertices[4];
+            u_long* entry = CachedQuadOTEntry(c0, c1, c2, c3, OTL_World);
 
-        if (tmp->depth == 0) {
-            for (size_t v = 0; v < 4; v++) {
-                modVertices[v] = tmp->verticesPtr[tmp->indicesPtr[v]];
+            if (entry == NULL) {
+                continue;
+            }
 
-                modVertices[v].vx /= tmp->subdivs;
-                if (modVertices[v].vy == 0) {
-                    modVertices[v].vy = -sh * vertYinv;
-                }
-                else {
-                    modVertices[v].vy = -sh * (vertYinv + 1);
-                }
+            POLY_FT4* poly = CopyPrim(tmpl, sizeof(POLY_FT4));
 
-                modVertices[v].vx += sw * vertX;
+            if (poly == NULL) {
+                return;
             }
-        }
-        else if (tmp->height == 0) {
-            for (size_t v = 0; v < 4; v++) {
-                modVertices[v] = tmp->verticesPtr[tmp->indicesPtr[v]];
 
-                modVertices[v].vx /= tmp->subdivs;
+            setCachedXY4(poly, c0, c1, c2, c3);
 
-                if (modVertices[v].vz == 0) {
-                    modVertices[v].vz = sd * vertYinv;
-                }
-                else {
-                    modVertices[v].vz = sd * (vertYinv + 1);
-                }
-                
-                modVertices[v].vx += sw * vertX;
-            }
+            //OrderThing(&otz, tpobj->polyObj.drPrio);
+            AddPrimByTPage(entry, poly);
+            CommitPrim(sizeof(POLY_FT4));
         }
+    }
+}
 
-        if (vertX == (tmp->repeats * tmp->subdivs) - 1) {
-            vertX = 0;
-            vertY++;
-            vertYinv--;
-        }
-        else {
-            vertX++;
-        }
+// Far LOD of a collision box, its faces as F4s in the texture's average colour
+static void AddFlatPolyBox(StaticCollisionPolyBox* scpolybox, POLY_F4* tmpl) {
+    TransformMeshVertices(scpolybox->vertices, 8);
 
-        nclip = RotAverageNclip4(
-            &modVertices[tmp->indicesPtr[0]], &modVertices[tmp->indicesPtr[1]],
-            &modVertices[tmp->indicesPtr[2]], &modVertices[tmp->indicesPtr[3]],
-            (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &p, &otz, &flg
-        );
-        
-        if (nclip <= 0) {
+    for (size_t i = 0; i < 6; ++i, ++tmpl) {
+        const long* face = &scpolybox->indices[4 * i];
+        u_long* entry = CachedQuadOTEntry(face[0], face[1], face[2], face[3], OTL_World);
+
+        if (entry == NULL) {
             continue;
         }
-        
-        if ((otz > 0) && (otz < OTSIZE)) {
-            //OrderThing(&otz, tpobj->polyObj.drPrio);
-            AddPrim(&ot[otz], poly);
+
+        POLY_F4* poly = CopyPrim(tmpl, sizeof(POLY_F4));
+
+        if (poly == NULL) {
+            break;
         }
+
+        setCachedXY4(poly, face[0], face[1], face[2], face[3]);
+        AddPrim(entry, poly);
+        CommitPrim(sizeof(POLY_F4));
     }
 }
 
-static void AddStaticPolyBox(StaticCollisionPolyBox* scpolybox, u_long* ot) {
-    long p, otz, flg;
+static void AddStaticPolyBox(StaticCollisionPolyBox* scpolybox) {
+    long otz;
     int nclip;
 
+    if (scpolybox->lod > 0) {
+        AddFlatPolyBox(scpolybox, scpolybox->lods[scpolybox->lod].polyPtr);
+        return;
+    }
+
+    if (scpolybox->batchTransform) {
+        TransformMeshVertices(scpolybox->vertices, 8);
+
+        for (size_t i = 0; i < 6; ++i) {
+            const long* face = &scpolybox->indices[4 * i];
+            u_long* entry = CachedQuadOTEntry(face[0], face[1], face[2], face[3], OTL_World);
+
+            if (entry == NULL) {
+                continue;
+            }
+
+            POLY_FT4* poly = CopyPrim(&materialPrims[scpolybox->faceMaterials[i]], sizeof(POLY_FT4));
+
+            if (poly == NULL) {
+                break;
+            }
+
+            setCachedXY4(poly, face[0], face[1], face[2], face[3]);
+            AddPrimByTPage(entry, poly);
+            CommitPrim(sizeof(POLY_FT4));
+        }
+
+        return;
+    }
+
     for (size_t i = 0; i < 6; ++i) {
-        if (scpolybox->polys[i] == NULL) {
-            continue;
+        POLY_FT4* poly = CopyPrim(&materialPrims[scpolybox->faceMaterials[i]], sizeof(POLY_FT4));
+
+        if (poly == NULL) {
+            break;
         }
 
         // Non-Average version (RotNclip4) presents layering issues, at least tested on floor against Average cube
         nclip = RotAverageNclip4(
             &scpolybox->vertices[scpolybox->indices[(4 * i) + 0]], &scpolybox->vertices[scpolybox->indices[(4 * i) + 1]],
             &scpolybox->vertices[scpolybox->indices[(4 * i) + 2]], &scpolybox->vertices[scpolybox->indices[(4 * i) + 3]],
-            (long*)&scpolybox->polys[i]->x0, (long*)&scpolybox->polys[i]->x1, (long*)&scpolybox->polys[i]->x3, (long*)&scpolybox->polys[i]->x2, &p, &otz, &flg
+            (long*)&poly->x0, (long*)&poly->x1, (long*)&poly->x3, (long*)&poly->x2, &drawTemps->p, &otz, &drawTemps->flg
         );
 
         if (nclip <= 0) {
             continue;
         }
         
-        if ((otz > 0) && (otz < OTSIZE)) {
-            AddPrim(&ot[otz], scpolybox->polys[i]);
+        u_long* entry = OTEntry(OTL_World, otz);
+
+        if (entry != NULL) {
+            AddPrimByTPage(entry, poly);
+            CommitPrim(sizeof(POLY_FT4));
+        }
+    }
+}
+
+// Draws one object of a static chunk, the same way its kind's loop in main() would without loading its matrix
+static void AddChunkMember(CameraObject* camera, ChunkMember* member) {
+    switch (member->type) {
+        case LOT_PolyF4: {
+            PolyObject* pobj = member->object;
+
+            if (!CullObject(camera, &pobj->bounds)) {
+                UpdatePolyObjectLod(pobj);
+                AddPolyF(pobj);
+            }
+            break;
+        }
+        case LOT_PolyFT4: {
+            TexturedPolyObject* tpobj = member->object;
+            PolyObject* pobj = &tpobj->polyObj;
+
+            if (CullObject(camera, &pobj->bounds)) {
+                break;
+            }
+
+            UpdatePolyObjectLod(pobj);
+
+            if (pobj->lods != NULL && pobj->lods[pobj->lod].flat) {
+                AddPolyF(pobj);
+            }
+            else {
+                AddPolyFT(tpobj);
+            }
+            break;
+        }
+        case LOT_MultiPoly: {
+            TestTileMultiPoly* tmp = member->object;
+
+            if (!CullObject(camera, &tmp->bounds)) {
+                AddMultiPoly(tmp);
+            }
+            break;
+        }
+        case LOT_ColBox: {
+            StaticCollisionPolyBox* scpolybox = member->object;
+
+            if (CullObject(camera, &scpolybox->bounds)) {
+                break;
+            }
+
+            if (scpolybox->lods != NULL) {
+                scpolybox->lod = SelectLod(scpolybox->lods, scpolybox->lodCount, scpolybox->lod, scpolybox->bounds.viewDepth);
+            }
+
+            AddStaticPolyBox(scpolybox);
+            break;
+        }
+    }
+}
+
+// Draws the static chunks in view. Their members are already in world space, so the camera's matrix is loaded once for all of them
+static void AddStaticChunks(CameraObject* camera) {
+    gte_SetRotMatrix(&camera->transform);
+    gte_SetTransMatrix(&camera->transform);
+
+    for (size_t c = 0; c < staticChunkCount; c++) {
+        StaticChunk* chunk = &staticChunks[c];
+
+        if (IsCellHidden(chunk->cell, chunk->memberCount)) {
+            continue;
+        }
+
+        if (!IsObjectVisible(camera, &chunk->bounds)) {
+            ProfilerCount(PRC_Culled, chunk->memberCount);
+            continue;
+        }
+
+        for (size_t m = 0; m < chunk->memberCount; m++) {
+            AddChunkMember(camera, &chunkMembers[chunk->firstMember + m]);
         }
     }
 }
 
 static void UpdatePlayerCamera(VECTOR* tPos, VECTOR* cPos, SVECTOR* cRot) {
+    MATRIX previous = player->cameraPtr->transform;
+
     RotMatrix(cRot, &player->cameraPtr->transform);
 
     tPos->vx = player->poly.obj.position.vx >> 12;
@@ -1029,14 +2648,23 @@ static void UpdatePlayerCamera(VECTOR* tPos, VECTOR* cPos, SVECTOR* cRot) {
 
     ApplyMatrixLV(&player->cameraPtr->transform, cPos, cPos);
     TransMatrix(&player->cameraPtr->transform, cPos);
+
+    // Every object's composed transform goes stale with it
+    if (memcmp(&previous, &player->cameraPtr->transform, sizeof(MATRIX)) != 0) {
+        player->cameraPtr->transformStamp++;
+    }
     
     gte_SetRotMatrix(&player->cameraPtr->transform);
     gte_SetTransMatrix(&player->cameraPtr->transform);
 }
 
-void resetCube(SVECTOR* rot, VECTOR* trans) {
-    setVector(rot, 0, 0, 0);
-    setVector(trans, 0, (-CUBEHALF - 32) * ONE, DISTTHING * ONE);
+// Puts every object spun by auto rotation back to its starting orientation
+static void ResetRotatingObjects() {
+    for (size_t i = 0; i < activePolygonCount; i++) {
+        if (activePolygons[i]->obj.autoRotates) {
+            setVector(&activePolygons[i]->obj.rotation, 0, 0, 0);
+        }
+    }
 }
 
 int main(void) {
@@ -1048,11 +2676,12 @@ int main(void) {
     // Function signature for InitHeap() takes a starting address and a size for the heap in bytes (size needs to be a multiple of 4)
     // InitHeap() only allows standard malloc(), calloc(), free(), etc. The numbered versions, eg malloc<2 or 3>(), require use of InitHeap<2 or 3>() instead
 
+    // The heap ends at 0x80080000, which is where the input recording starts (REPLAYADDRESS)
     // Maybe __heap_start could be funny
     InitHeap((u_long*)0x80040000, (u_long)0x40000);
 
     InitGraphics();
-    drModeList = malloc(sizeof(DR_MODE) * SPECPRIMSSIZE);
+    InitDrawScratchpad();
 
     GamePad pad0 = { 0 };
     GamePad pad1 = { 0 };
@@ -1065,12 +2694,12 @@ int main(void) {
 
     VECTOR cPos = { 0 };
     
-    int PadStatus;
     int TPressed = 0;
     int AutoRotate = 1;
+    int PPressed = 0;
 
     // Initialises the controllers with the Kernel library function. Max data buffer size is 34B
-    InitPAD(pad0.dataBuffer, 34, pad1.dataBuffer, 34);
+    InitPAD((char*)pad0.dataBuffer, 34, (char*)pad1.dataBuffer, 34);
     StartPAD();
 
     // Seed rand for same result every time
@@ -1083,250 +2712,26 @@ int main(void) {
 
     CreatePlayer(col);
 
-    PolyObject* colPlatform = CreatePolyObjectF4(
-        0, -24, DISTTHING / 2, 
-        0, 0, 0,
-        6, 4, colBoxVertices, cubeIndices,
-        DRP_Neutral, 
-        true, 12, 64, true, col
-    );
-
-    PolyObject* cube = CreatePolyObjectF4(
-        0, -CUBEHALF - 32, DISTTHING, 
-        0, 0, 0,
-        6, 4, cubeVertices, cubeIndices,
-        DRP_Neutral, 
-        false, 0, 0, false, col
-    );
-
-
-    TexturedPolyObject* floor = CreateTexturedPolyObjectFT4(
-        0, 0, DISTTHING, 
-        //ONE / 2, 0, 0,
-        0, 0, 0,
-        1, 4, floorVertices, floorIndices,
-        DRP_Low, 
-        false, 0, 0, true, 
-        &cobble_tim, 
-        0, 127, 128, 128, 
-        false,
-        0, 127, 128, 128
-    );
-
-    TexturedPolyObject* tWallLeft = CreateTexturedPolyObjectFT4(
-        192, 0, 96, 
-        0, 0, 0,
-        //6, 4, tWallVertices, cubeIndices,
-        4, 4, tWallVertices, tubeIndices,
-        DRP_Neutral, 
-        false, 0, 0, true, 
-        &woodPanel_tim, 
-        //0, 0, 128, 128, 
-        0, 0, 64, 128, 
-        true,
-        0, 0, 64, 128
-    );
-
-    TexturedPolyObject* tDoor = CreateTexturedPolyObjectFT4(
-        //192 + WALLHALF * 2 - DOORHALF, 0, 96, 
-        192 + WALLHALF * 2, 0, 96, 
-        0, 0, 0,
-        6, 4, tDoorVertices, cubeIndices,
-        DRP_Neutral, 
-        false, 0, 0, true, 
-        &woodDoor_tim, 
-        63, 0, 64, 128, 
-        false,
-        63, 0, 64, 128
-    );
-
-    TexturedPolyObject* tWallRight = CreateTexturedPolyObjectFT4(
-        //192 + WALLHALF * 2 + DOORHALF * 2, 0, 96, 
-        192 + WALLHALF * 2 + DOORHALF * 2, 0, 96, 
-        0, 0, 0,
-        //6, 4, tWallVertices, cubeIndices,
-        4, 4, tWallVertices, tubeIndices,
-        DRP_Neutral, 
-        false, 0, 0, true, 
-        &woodPanel_tim, 
-        //0, 0, 128, 128, 
-        0, 0, 64, 128, 
-        true,
-        0, 0, 64, 128
-    );
-
-    TexturedPolyObject* longFloor = CreateTexturedPolyObjectFT4(
-        //288, 0, -32, 
-        192, 0, -32, 
-        //ONE / 2, 0, 0,
-        0, 0, 0,
-        1, 4, longFloorVertices, floorIndices,
-        DRP_Low, 
-        false, 0, 0, true, 
-        &cobble_tim, 
-        //0, 127, 255, 128,
-        0, 127, 128, 128,
-        true,
-        0, 127, 128, 128
-    );
-
-    TexturedPolyObject* tiledWall = CreateTexturedPolyObjectFT4(
-        192 + WALLHALF * 4 + DOORHALF * 3, 0, 96, 
-        0, 0, 0,
-        //6, 4, tWallVertices, cubeIndices,
-        5, 4, tiledPanelVertices, tileWallIndices,
-        DRP_Neutral, 
-        false, 0, 0, true, 
-        &woodPanel_tim, 
-        //0, 0, 128, 128, 
-        0, 0, 64, 128, 
-        false,
-        0, 0, 64, 128
-    );
-
-
-    TestTileMultiPoly* testPoly = CreateTestMultiPoly(
-        -320, 0, 96,
-        0, 0, 0,
-        6, 2, false,
-        1, 0, 0,
-        64, 128, 0,
-        &woodPanel_tim, 
-        0, 0, 64, 128
-    );
-
-    TestTileMultiPoly* testPolyFloor = CreateTestMultiPoly(
-        -320, 0, -32,
-        0, 0, 0,
-        3, 2, false,
-        1, 0, 0,
-        128, 0, 128,
-        &cobble_tim, 
-        0, 127, 128, 128
-    );
-    
-
-    int heightDif;
-    bool occupiesSameSpace = false;
-
-    activePolygons[0] = &player->poly;
-    activePolygons[1] = cube;
-    activePolygons[2] = colPlatform;
-
-    activeTexPolygons[0] = floor;
-    activeTexPolygons[1] = tWallLeft;
-    activeTexPolygons[2] = tWallRight;
-    activeTexPolygons[3] = tDoor;
-    activeTexPolygons[4] = longFloor;
-
-    activeTiledTexPolygons[0] = tiledWall;
-
-
-    // Should really do something about these "constructors". They're really long
-
-    StaticCollisionPolyBox* testPolyBox = CreateCollisionPolyBox(
-        640, 0, -64,
-        0, 0, 0,
-        tinyHouseVertices
-    );
-
-    testPolyBox->polys[0] = CreateTexturedPolygon4(&woodDoor_tim, 63, 0, 64, 128);
-    testPolyBox->polys[1] = CreateTexturedPolygon4(&woodPanel_tim, 0, 0, 64, 128);
-    testPolyBox->polys[2] = CreateTexturedPolygon4(&woodPanel_tim, 0, 0, 64, 128);
-    testPolyBox->polys[3] = CreateTexturedPolygon4(&woodPanel_tim, 0, 0, 64, 128);
-    testPolyBox->polys[4] = CreateTexturedPolygon4(&woodPanel_tim, 0, 0, 64, 128);
-    testPolyBox->polys[5] = CreateTexturedPolygon4(&woodPanel_tim, 0, 0, 64, 128);
-
-    activeCollisionPolyBoxes[0] = testPolyBox;
-
-
-    StaticCollisionPolyBox* testPolyBox2 = CreateCollisionPolyBox(
-        544, 0, -64,
-        0, 0, 0,
-        tinyBoxVertices
-    );
-
-    testPolyBox2->polys[0] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox2->polys[1] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox2->polys[2] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox2->polys[3] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox2->polys[4] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox2->polys[5] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-
-    activeCollisionPolyBoxes[1] = testPolyBox2;
-
-
-    StaticCollisionPolyBox* testPolyBox3 = CreateCollisionPolyBox(
-        576, 0, -64,
-        0, 0, 0,
-        boxVertices
-    );
-
-    testPolyBox3->polys[0] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox3->polys[1] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox3->polys[2] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox3->polys[3] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox3->polys[4] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox3->polys[5] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-
-    activeCollisionPolyBoxes[2] = testPolyBox3;
-
-
-    StaticCollisionPolyBox* testPolyBox4 = CreateCollisionPolyBox(
-        784, -112, -64,
-        0, 0, 0,
-        platformVertices
-    );
-
-    testPolyBox4->polys[0] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox4->polys[1] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox4->polys[2] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox4->polys[3] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox4->polys[4] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox4->polys[5] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-
-    activeCollisionPolyBoxes[3] = testPolyBox4;
-
-
-    StaticCollisionPolyBox* testPolyBox5 = CreateCollisionPolyBox(
-        784, -72, -96,
-        0, 0, 0,
-        platformVertices
-    );
-
-    testPolyBox5->polys[0] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox5->polys[1] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox5->polys[2] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox5->polys[3] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox5->polys[4] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox5->polys[5] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-
-    activeCollisionPolyBoxes[4] = testPolyBox5;
-
-
-    StaticCollisionPolyBox* testPolyBox6 = CreateCollisionPolyBox(
-        784, -32, -128,
-        0, 0, 0,
-        platformVertices
-    );
+    activePolygons[activePolygonCount++] = &player->poly;
 
-    testPolyBox6->polys[0] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox6->polys[1] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox6->polys[2] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox6->polys[3] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox6->polys[4] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-    testPolyBox6->polys[5] = CreateTexturedPolygon4(&cobble_tim, 0, 127, 128, 128);
-
-    activeCollisionPolyBoxes[5] = testPolyBox6;
+    if (!LoadLevel(testlevel_start, (char*)testlevel_end - (char*)testlevel_start)) {
+        printf("Failed to load level\n");
+        return 1;
+    }
 
     // Wait for VBLANK to allow controller to initialise (otherwise it starts off with pad->buttons being FFFF for the first frame)
     VSync(0);
 
-    while (1) {
+    ProfilerInit();
+    ReplayInit(REPLAYMODE);
+
+    while (KEEPRUNNING()) {
         rRot.vx = player->cameraPtr->rotation.vx >> 12;
         rRot.vy = player->cameraPtr->rotation.vy >> 12;
         rRot.vz = player->cameraPtr->rotation.vz >> 12;
 
+        ProfilerBegin(PRS_Input);
+
         // Translate pad data buffer into a readable format
         UpdatePad(&pad0);
 
@@ -1350,7 +2755,7 @@ int main(void) {
             */
 
             if (pad0.buttons & PADselect) {
-                resetCube(&cube->obj.rotation, &cube->obj.position);
+                ResetRotatingObjects();
             }
 
             if (pad0.buttons & PADstart) {
@@ -1364,6 +2769,18 @@ int main(void) {
                 TPressed = 0;
             }
 
+            // Toggles the profiler overlay
+            if (pad0.buttons & PADL2) {
+                if (PPressed == 0) {
+                    ProfilerToggle();
+                }
+
+                PPressed = 1;
+            }
+            else {
+                PPressed = 0;
+            }
+
             // Clean this up later, preferably by writing a separate file for input handling
             VECTOR inputVelocity = { 0 };
 
@@ -1411,8 +2828,12 @@ int main(void) {
             }
         }
 
+        ProfilerEnd(PRS_Input);
+
         // Simulates player movement and resolves collision, then moves the player accordingly
+        ProfilerBegin(PRS_Collision);
         SimulatePlayerMovementCollision();
+        ProfilerEnd(PRS_Collision);
 
         if (isPlayerOnCollision) {
             isPlayerOnFloor = true;
@@ -1435,67 +2856,149 @@ int main(void) {
                 player->poly.obj.velocity.vy -= 8 * ONE;
             }
         }
-        else {
+        else if (player->poly.obj.velocity.vy < PLAYERMAXFALLSPEED) {
             player->poly.obj.velocity.vy += ONE / 2;
         }
         
         if (AutoRotate) {
-            cube->obj.rotation.vy += 16;
-            cube->obj.rotation.vz += 16;
+            for (size_t i = 0; i < activePolygonCount; i++) {
+                if (activePolygons[i]->obj.autoRotates) {
+                    activePolygons[i]->obj.rotation.vy += 16;
+                    activePolygons[i]->obj.rotation.vz += 16;
+                }
+            }
         }
 
-        for (size_t i = 0; i < ACTIVEPOLYGONCOUNT; i++) {
+        ProfilerBegin(PRS_Update);
+
+        for (size_t i = 0; i < activePolygonCount; i++) {
             UpdatePolyObject(activePolygons[i]);
         }
-        for (size_t i = 0; i < ACTIVETEXPOLYGONCOUNT; i++) {
+        for (size_t i = 0; i < activeTexPolygonCount; i++) {
             UpdatePolyObject(&activeTexPolygons[i]->polyObj);
         }
-        for (size_t i = 0; i < ACTIVETILEDTEXPOLYGONCOUNT; i++) {
+        for (size_t i = 0; i < activeTiledTexPolygonCount; i++) {
             UpdatePolyObject(&activeTiledTexPolygons[i]->polyObj);
         }
 
         UpdatePlayerCamera(&rPos, &cPos, &rRot);
 
-        // Swap used buffer. This and the OT reset/population should be moved to DrawFrame eventually when more things, like the player and camera, are moved to global space
-        cdb = (cdb == &db[0]) ? &db[1] : &db[0];
+        VECTOR eye = {
+            player->cameraPtr->position.vx >> 12,
+            player->cameraPtr->position.vy >> 12,
+            player->cameraPtr->position.vz >> 12, 0
+        };
+
+        CellsUpdateVisibility(&cellGraph, &player->cameraPtr->transform, &eye);
 
-        // Initialises a linked list for OT / clears (zeroes?) OT for current frame in reverse order (faster)
-        // "When an OT is initialized, the polygons are unlinked, and only then is a re-sort possible. 
-        // Therefore, it is always necessary to initialize an OT prior to executing a sort." - Library Overview, 10-8
-        ClearOTagR(cdb->ot, OTSIZE);
+        ProfilerEnd(PRS_Update);
 
+        // cdb has already been swapped and cleared by the last DrawFrame()
         // Add polys to OT
-        for (size_t i = 0; i < ACTIVEPOLYGONCOUNT; i++) {
-            CameraTransformMatrix(player->cameraPtr, &activePolygons[i]->obj.transform);
-            AddPolyF(activePolygons[i], cdb->ot);
+        ProfilerBegin(PRS_OTPolyF);
+        for (size_t i = 0; i < activePolygonCount; i++) {
+            if (activePolygons[i]->obj.chunked || IsCellHidden(activePolygons[i]->obj.cell, 1) || CullObject(player->cameraPtr, &activePolygons[i]->bounds)) {
+                continue;
+            }
+
+            UpdatePolyObjectLod(activePolygons[i]);
+            CameraTransformMatrix(player->cameraPtr, &activePolygons[i]->obj.transform, activePolygons[i]->obj.transformStamp, &activePolygons[i]->obj.render);
+            AddPolyF(activePolygons[i]);
         }
+        ProfilerEnd(PRS_OTPolyF);
         
-        for (size_t i = 0; i < ACTIVETEXPOLYGONCOUNT; i++) {
-            CameraTransformMatrix(player->cameraPtr, &activeTexPolygons[i]->polyObj.obj.transform);
-            AddPolyFT(activeTexPolygons[i], cdb->ot);
+        ProfilerBegin(PRS_OTPolyFT);
+        for (size_t i = 0; i < activeTexPolygonCount; i++) {
+            if (activeTexPolygons[i]->polyObj.obj.chunked || IsCellHidden(activeTexPolygons[i]->polyObj.obj.cell, 1)
+                || CullObject(player->cameraPtr, &activeTexPolygons[i]->polyObj.bounds)) {
+                continue;
+            }
+
+            PolyObject* pobj = &activeTexPolygons[i]->polyObj;
+
+            UpdatePolyObjectLod(pobj);
+            CameraTransformMatrix(player->cameraPtr, &pobj->obj.transform, pobj->obj.transformStamp, &pobj->obj.render);
+
+            if (pobj->lods != NULL && pobj->lods[pobj->lod].flat) {
+                AddPolyF(pobj);
+            }
+            else {
+                AddPolyFT(activeTexPolygons[i]);
+            }
+        }
+        ProfilerEnd(PRS_OTPolyFT);
+
+        ProfilerBegin(PRS_OTTiled);
+        for (size_t i = 0; i < activeTiledTexPolygonCount; i++) {
+            if (IsCellHidden(activeTiledTexPolygons[i]->polyObj.obj.cell, 1) || CullObject(player->cameraPtr, &activeTiledTexPolygons[i]->polyObj.bounds)) {
+                continue;
+            }
+
+            GameObject* obj = &activeTiledTexPolygons[i]->polyObj.obj;
+
+            CameraTransformMatrix(player->cameraPtr, &obj->transform, obj->transformStamp, &obj->render);
+            AddTiledPolyFT(activeTiledTexPolygons[i]);
         }
+        ProfilerEnd(PRS_OTTiled);
+
+        ProfilerBegin(PRS_OTMulti);
+        for (size_t i = 0; i < activeMultiPolyCount; i++) {
+            if (activeMultiPolys[i]->obj.chunked || IsCellHidden(activeMultiPolys[i]->obj.cell, 1) || CullObject(player->cameraPtr, &activeMultiPolys[i]->bounds)) {
+                continue;
+            }
 
-        for (size_t i = 0; i < ACTIVETILEDTEXPOLYGONCOUNT; i++) {
-            CameraTransformMatrix(player->cameraPtr, &activeTiledTexPolygons[i]->polyObj.obj.transform);
-            AddTiledPolyFT(activeTiledTexPolygons[i], cdb->ot);
+            CameraTransformMatrix(player->cameraPtr, &activeMultiPolys[i]->obj.transform, activeMultiPolys[i]->obj.transformStamp, &activeMultiPolys[i]->obj.render);
+            AddMultiPoly(activeMultiPolys[i]);
         }
+        ProfilerEnd(PRS_OTMulti);
+
+        ProfilerBegin(PRS_OTColBox);
+        for (size_t i = 0; i < activeCollisionPolyBoxCount; i++) {
+            if (activeCollisionPolyBoxes[i]->chunked || IsCellHidden(activeCollisionPolyBoxes[i]->cell, 1)
+                || CullObject(player->cameraPtr, &activeCollisionPolyBoxes[i]->bounds)) {
+                continue;
+            }
 
-        CameraTransformMatrix(player->cameraPtr, &testPoly->obj.transform);
-        AddMultiPoly(testPoly, cdb->ot);
+            StaticCollisionPolyBox* scpolybox = activeCollisionPolyBoxes[i];
 
-        CameraTransformMatrix(player->cameraPtr, &testPolyFloor->obj.transform);
-        AddMultiPoly(testPolyFloor, cdb->ot);
+            if (scpolybox->lods != NULL) {
+                scpolybox->lod = SelectLod(scpolybox->lods, scpolybox->lodCount, scpolybox->lod, scpolybox->bounds.viewDepth);
+            }
 
-        for (size_t i = 0; i < ACTIVECOLBOXCOUNT; i++) {
-            CameraTransformMatrix(player->cameraPtr, &activeCollisionPolyBoxes[i]->transform);
-            AddStaticPolyBox(activeCollisionPolyBoxes[i], cdb->ot);
+            CameraTransformMatrix(player->cameraPtr, &scpolybox->transform, 0, &scpolybox->render); // Never moves
+            AddStaticPolyBox(scpolybox);
         }
+        ProfilerEnd(PRS_OTColBox);
+
+        ProfilerBegin(PRS_OTChunks);
+        AddStaticChunks(player->cameraPtr);
+        ProfilerEnd(PRS_OTChunks);
 
         //FntPrint("PT: %04d, %04d, %04d\n", player->poly.obj.transform.t[0], player->poly.obj.transform.t[1], player->poly.obj.transform.t[2]);
         //FntPrint("PV : %06d, %06d, %06d\n", player->poly.obj.velocity.vx, player->poly.obj.velocity.vy, player->poly.obj.velocity.vz);
 
+        if (profilerEnabled) {
+            ProfilerCount(PRC_TPageSwitches, CountTPageSwitches());
+        }
+
+        ReplayPrint();
+        ProfilerPrint();
         DrawFrame();
+        ProfilerEndFrame();
     }
 
+#ifdef HOST
+    ProfilerReport();
+    printf("scratchpad: %zu of %d bytes used\n", ScratchpadUsed(), SCRATCHPADSIZE);
+    PrintPools();
+
+    if (getenv("PSX_RELOADCHECK") != NULL && !CheckLevelReload(testlevel_start, (char*)testlevel_end - (char*)testlevel_start)) {
+        printf("Level changed when loaded again\n");
+        return 1;
+    }
+
+    UnloadLevels();
+#endif
+
     return 0;
 }
@@ -25,15 +25,51 @@ typedef struct RemoteCollisionBox {
     CollisionBox cbox;
 } RemoteCollisionBox;
 
+// Sphere enclosing all of an object's vertices, used to skip whole objects that can't be seen
+typedef struct BoundingSphere {
+    SVECTOR centre;     // Local space
+    VECTOR worldCentre; // Centre after the object's transform. Has to be refreshed whenever the transform changes
+    long radius;
+    long viewDepth;     // Camera space depth of the centre as of the last visibility test, picks the LOD
+} BoundingSphere;
+
+// One of an object's meshes, from full detail at index 0 to the cheapest, see SelectLod()
+typedef struct LodLevel {
+    long distance;        // Camera space depth it takes over from
+    void* polyPtr;        // Templates, POLY_F4 if flat and POLY_FT4 otherwise
+    SVECTOR* verticesPtr;
+    long* indicesPtr;
+    ushort polyLength;
+    ushort vertexCount;
+    bool flat;            // Textured objects draw it untextured
+    bool batchTransform;
+} LodLevel;
+
+// An object's transform composed with the camera's, kept until either of them changes, see CameraTransformMatrix()
+typedef struct RenderTransform {
+    MATRIX transform;
+    u_long cameraStamp;
+    u_long objectStamp;
+} RenderTransform;
+
 typedef struct StaticCollisionPolyBox {
     VECTOR position;
     SVECTOR rotation;
     MATRIX transform;
+    RenderTransform render;
     CollisionBox colBox;
 
-    POLY_FT4* polys[6];
+    u_char faceMaterials[6]; // Into materialPrims, whose templates are copied into the frame's primitive arena when drawn
     SVECTOR* vertices;
     long* indices;
+    BoundingSphere bounds;
+    bool batchTransform; // Transform the 8 corners once, instead of 4 per face
+
+    LodLevel* lods; // lodCount meshes, NULL if there's only the box. Every level past the first is a flat one
+    u_char lodCount;
+    u_char lod;
+    bool chunked; // Vertices are in world space and it's drawn with its static chunk, see BuildStaticChunks()
+    u_char cell;  // Level cell it's in, skipped while the camera can't see into it. LEVELNOCELL if it isn't in one
 } StaticCollisionPolyBox;
 
 
@@ -43,9 +79,15 @@ typedef struct GameObject {
     VECTOR position; // Position to update the Transform with. Position is ONE (4096) bigger than the actual values stored in the Transform
     SVECTOR rotation;
     MATRIX transform;
+    SVECTOR transformRotation; // Rotation transform was last built from, see UpdatePolyObject()
+    u_long transformStamp;     // Bumped whenever transform changes
+    RenderTransform render;
     VECTOR velocity; // Velocity, expressed in fixed-point integers (* ONE)
     long maxSpeed;
     bool isStatic;
+    bool autoRotates; // Spun by the main loop while auto rotation is on
+    bool chunked;     // Same as StaticCollisionPolyBox's
+    u_char cell;      // Same as StaticCollisionPolyBox's, only ever set for static objects
 } GameObject;
 
 // Same as GameObject, except uses a VECTOR for rotation instead of SVECTOR
@@ -53,6 +95,7 @@ typedef struct CameraObject {
     VECTOR position;
     VECTOR rotation;
     MATRIX transform;
+    u_long transformStamp; // Bumped whenever transform changes, see UpdatePlayerCamera()
 } CameraObject;
 
 // Extends GameObject and can also hold all the data needed to draw a polygon
@@ -61,15 +104,23 @@ typedef struct PolyObject {
 
     u_char polySides;
     ushort polyLength;
-    void* polyPtr;
+    void* polyPtr; // Templates, copied into the frame's primitive arena when drawn
     SVECTOR* verticesPtr;
     long* indicesPtr;
+    ushort vertexCount; // Vertices the indices reach, only needed for batchTransform
     enum DrawPriority drPrio;
 
     int boxHeight;
     int boxWidth;
 
     bool collides;
+    bool batchTransform; // Transform every vertex once into the screen cache, instead of once per face using it (4-sided only)
+    BoundingSphere bounds;
+
+    // lodCount meshes, NULL if the object only has the one. The one in use is copied into the fields above
+    LodLevel* lods;
+    u_char lodCount;
+    u_char lod;
 
     //void (*add)(struct PolyObject* self, u_long* ot);
 } PolyObject;
@@ -79,6 +130,9 @@ typedef struct TexturedPolyObject {
     TIM_IMAGE* tim;
     RECT trect;
     bool repeating;
+    bool windowed;       // Repeating and its UVs reach past trect, so it's drawn with the texture window on
+    u_char windowTiles;  // Tiles one face can stretch over by wrapping in the texture window, repeating tiled objects only
+    bool subdivides; // Faces near the camera are split and clipped against the near plane (4-sided only)
 } TexturedPolyObject;
 
 typedef struct TestTileMultiPoly {
@@ -93,12 +147,13 @@ typedef struct TestTileMultiPoly {
     u_char height;
     u_char depth;
 
-    SVECTOR* verticesPtr;
-    long* indicesPtr;
-    POLY_FT4* polyPtr;
+    SVECTOR* verticesPtr; // Lattice of (repeats * subdivs + 1) * (subdivs + 1) vertices shared by all faces, see level.h
+    long* indicesPtr;     // Lattice offsets of a face's 4 corners
+    POLY_FT4* polyPtr; // Templates, copied into the frame's primitive arena when drawn
 
     u_char subdivs;
     ushort totalPolys;
+    BoundingSphere bounds;
 
     TIM_IMAGE* tim;
     //u_char u0;
@@ -110,6 +165,20 @@ typedef struct TestTileMultiPoly {
 
 } TestTileMultiPoly;
 
+// Static object drawn as part of a chunk, type is its LevelObjectType
+typedef struct ChunkMember {
+    u_char type;
+    void* object;
+} ChunkMember;
+
+// Static objects of one level cell, spatial cell and tpage, baked into world space so they all draw with the camera's matrix
+typedef struct StaticChunk {
+    BoundingSphere bounds; // Encloses all of its members, only worldCentre and radius are used
+    u_short firstMember;
+    u_short memberCount;
+    u_char cell;           // Shared by all of its members
+} StaticChunk;
+
 typedef struct PlayerObject {
     PolyObject poly;
     CameraObject* cameraPtr;
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pool.h"
+
+// Takes a zeroed item, NULL if all of them are in use
+void* PoolAlloc(Pool* pool) {
+    void* item = NULL;
+
+    if (pool->freeList != NULL) {
+        item = pool->freeList;
+        pool->freeList = *(void**)item;
+    }
+    else if (pool->top < pool->capacity) {
+        item = pool->items + pool->top * pool->itemSize;
+        pool->top++;
+    }
+    else {
+        return NULL;
+    }
+
+    memset(item, 0, pool->itemSize);
+    pool->used++;
+    pool->peak = (pool->used > pool->peak) ? pool->used : pool->peak;
+
+    return item;
+}
+
+// Gives item back to the pool it came from. Nothing may point at it afterwards
+void PoolFree(Pool* pool, void* item) {
+    if (item == NULL) {
+        return;
+    }
+
+    *(void**)item = pool->freeList;
+    pool->freeList = item;
+    pool->used--;
+}
+
+// Gives back every item at once, e.g. when the objects of a level go away
+void PoolReset(Pool* pool) {
+    pool->top = 0;
+    pool->used = 0;
+    pool->freeList = NULL;
+}
+
+u_short PoolFreeCount(const Pool* pool) {
+    return pool->capacity - pool->used;
+}
+
+void PoolPrint(const Pool* pool) {
+    printf("%-16s %3u used %3u peak %3u capacity, %lu bytes\n", pool->name, pool->used, pool->peak, pool->capacity,
+        (u_long)(pool->capacity * pool->itemSize));
+}
@@ -0,0 +1,32 @@
+#ifndef __POOL_H
+#define __POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <libgte.h>
+
+// Fixed number of same-sized items in a static array, handed out one at a time and given back in any order
+// Given back items are reused first, so spawning and despawning never fragments anything
+typedef struct Pool {
+    const char* name;
+    char* items;
+    size_t itemSize;   // At least a pointer, the free list is linked through given back items
+    u_short capacity;
+    u_short top;       // Items below this have been handed out at some point
+    u_short used;      // Handed out right now
+    u_short peak;      // Most ever used at once, kept by PoolReset() so capacities can be sized from it
+    void* freeList;
+} Pool;
+
+// Defines pool along with the array backing it, so its size is known at compile time
+#define POOLDEFINE(pool, type, count) \
+    static type pool##Items[count]; \
+    Pool pool = { #pool, (char*)pool##Items, sizeof(type), count, 0, 0, 0, NULL }
+
+void* PoolAlloc(Pool* pool);
+void PoolFree(Pool* pool, void* item);
+void PoolReset(Pool* pool);
+u_short PoolFreeCount(const Pool* pool);
+void PoolPrint(const Pool* pool);
+
+#endif
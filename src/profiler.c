@@ -0,0 +1,202 @@
+#include <stddef.h>
+#include <libgte.h>
+#include <libetc.h>
+#include <libgpu.h>
+#include <libapi.h>
+
+#ifdef HOST
+#include <stdio.h>
+#endif
+
+#include "profiler.h"
+
+#ifdef HOST
+// Headless runs have no pad to switch it on with
+bool profilerEnabled = true;
+#else
+bool profilerEnabled = false;
+#endif
+
+#if PROFILER
+
+static ProfilerStats profilerStats[PRS_Count];
+static u_char windowFrame = 0;
+static u_short profilerCounters[PRC_Count];
+static u_long runCounters[PRC_Count];
+static u_long runFrames = 0;
+
+// Padded to the same width so the columns line up
+static const char* scopeNames[PRS_Count] = {
+    "FRAME     ",
+    "INPUT     ",
+    "COLLIDE   ",
+    "UPDATE    ",
+    "OT F      ",
+    "OT FT     ",
+    "OT TILED  ",
+    "OT MULTI  ",
+    "OT COLBOX ",
+    "OT CHUNKS ",
+    "VBLANK    ",
+    "DRAWSYNC  "
+};
+
+static void ResetWindow() {
+    for (size_t i = 0; i < PRS_Count; i++) {
+        profilerStats[i].windowMin = 0xFFFF;
+        profilerStats[i].windowMax = 0;
+        profilerStats[i].windowSum = 0;
+    }
+
+    windowFrame = 0;
+}
+
+void ProfilerInit() {
+    // Root counter 1 counts horizontal blanks. Left free-running over its full 16-bit range, so
+    // differences stay correct across wrap-around as long as a scope lasts less than ~4 seconds
+    SetRCnt(RCntCNT1, 0xFFFF, RCntMdNOINTR);
+    StartRCnt(RCntCNT1);
+
+    ResetWindow();
+    profilerStats[PRS_Frame].start = GetRCnt(RCntCNT1);
+}
+
+void ProfilerToggle() {
+    profilerEnabled = !profilerEnabled;
+
+    // Drop whatever was half-measured while the profiler was off
+    ResetWindow();
+
+    for (size_t i = 0; i < PRS_Count; i++) {
+        profilerStats[i].frameTotal = 0;
+        profilerStats[i].runSum = 0;
+    }
+
+    for (size_t i = 0; i < PRC_Count; i++) {
+        profilerCounters[i] = 0;
+        runCounters[i] = 0;
+    }
+
+    runFrames = 0;
+    profilerStats[PRS_Frame].start = GetRCnt(RCntCNT1);
+}
+
+void ProfilerBegin(enum ProfilerScope scope) {
+    if (!profilerEnabled) {
+        return;
+    }
+
+    profilerStats[scope].start = GetRCnt(RCntCNT1);
+}
+
+void ProfilerEnd(enum ProfilerScope scope) {
+    if (!profilerEnabled) {
+        return;
+    }
+
+    profilerStats[scope].frameTotal += (u_short)(GetRCnt(RCntCNT1) - profilerStats[scope].start);
+}
+
+void ProfilerCount(enum ProfilerCounter counter, u_short amount) {
+    if (!profilerEnabled) {
+        return;
+    }
+
+    profilerCounters[counter] += amount;
+}
+
+// Folds this frame's totals into the current window, and publishes min/avg/max once the window is full
+void ProfilerEndFrame() {
+    if (!profilerEnabled) {
+        return;
+    }
+
+    ProfilerEnd(PRS_Frame);
+    ProfilerBegin(PRS_Frame);
+
+    for (size_t i = 0; i < PRS_Count; i++) {
+        ProfilerStats* stats = &profilerStats[i];
+
+        if (stats->frameTotal < stats->windowMin) {
+            stats->windowMin = stats->frameTotal;
+        }
+        if (stats->frameTotal > stats->windowMax) {
+            stats->windowMax = stats->frameTotal;
+        }
+
+        stats->windowSum += stats->frameTotal;
+        stats->runSum += stats->frameTotal;
+        stats->frameTotal = 0;
+    }
+
+    for (size_t i = 0; i < PRC_Count; i++) {
+        runCounters[i] += profilerCounters[i];
+        profilerCounters[i] = 0;
+    }
+
+    runFrames++;
+
+    windowFrame++;
+
+    if (windowFrame == PROFILERWINDOW) {
+        for (size_t i = 0; i < PRS_Count; i++) {
+            profilerStats[i].min = profilerStats[i].windowMin;
+            profilerStats[i].avg = profilerStats[i].windowSum / PROFILERWINDOW;
+            profilerStats[i].max = profilerStats[i].windowMax;
+        }
+
+        ResetWindow();
+    }
+}
+
+void ProfilerPrint() {
+    if (!profilerEnabled) {
+        return;
+    }
+
+    FntPrint("HSYNC      MIN AVG MAX\n");
+
+    for (size_t i = 0; i < PRS_Count; i++) {
+        FntPrint("%s%03d %03d %03d\n", scopeNames[i], profilerStats[i].min, profilerStats[i].avg, profilerStats[i].max);
+    }
+
+    FntPrint("\nOBJECTS DRAWN %03d CULLED %03d HIDDEN %03d\n", profilerCounters[PRC_Drawn], profilerCounters[PRC_Culled], profilerCounters[PRC_Hidden]);
+    FntPrint("TPAGE SWITCHES %03d COMPOSED %03d\n", profilerCounters[PRC_TPageSwitches], profilerCounters[PRC_Composed]);
+    FntPrint("CLIPPED FACES %03d\n", profilerCounters[PRC_Clipped]);
+}
+
+#ifdef HOST
+// Whole-run summary for headless runs, in microseconds
+void ProfilerReport() {
+    static const char* counterNames[PRC_Count] = {
+        "drawn objects",
+        "culled objects",
+        "hidden objects",
+        "clipped faces",
+        "tpage switches",
+        "composed xforms"
+    };
+
+    if (runFrames == 0) {
+        return;
+    }
+
+    printf("profile: %lu frames\n", runFrames);
+    printf("%-12s %10s %10s %10s %10s\n", "scope", "avg us", "min us", "max us", "total ms");
+
+    for (size_t i = 0; i < PRS_Count; i++) {
+        // min/max only cover the last full window
+        printf("%-12s %10.2f %10.2f %10.2f %10.2f\n", scopeNames[i],
+            (double)profilerStats[i].runSum * PROFILERTICKNS / runFrames / 1000.0,
+            (double)profilerStats[i].min * PROFILERTICKNS / 1000.0,
+            (double)profilerStats[i].max * PROFILERTICKNS / 1000.0,
+            (double)profilerStats[i].runSum * PROFILERTICKNS / 1000000.0);
+    }
+
+    for (size_t i = 0; i < PRC_Count; i++) {
+        printf("%-16s %8.1f per frame\n", counterNames[i], (double)runCounters[i] / runFrames);
+    }
+}
+#endif
+
+#endif
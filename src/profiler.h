@@ -0,0 +1,91 @@
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <stdbool.h>
+#include <libgte.h>
+
+// 1 = scopes are timed and can be shown on screen, 0 = every profiler call compiles to nothing
+#ifndef PROFILER
+#define PROFILER 1
+#endif
+
+// Number of frames each min/avg/max window covers
+#define PROFILERWINDOW 32
+
+// Length of one counter tick. The host shim's counters run much faster than the console's hsync counter
+#ifdef HOST
+#define PROFILERTICKNS 100
+#else
+#define PROFILERTICKNS 63556
+#endif
+
+// Everything is measured in horizontal blanks (root counter 1), ~63.6 microseconds each. A 60 Hz frame is ~262 of them
+enum ProfilerScope {
+    PRS_Frame,
+    PRS_Input,
+    PRS_Collision,
+    PRS_Update,
+    PRS_OTPolyF,
+    PRS_OTPolyFT,
+    PRS_OTTiled,
+    PRS_OTMulti,
+    PRS_OTColBox,
+    PRS_OTChunks,
+    PRS_VBlank,   // Waiting for the VBLANK that hands the last frame to the GPU, time the GPU isn't measured in
+    PRS_DrawSync, // Waiting for the GPU to finish drawing
+    PRS_Count
+};
+
+// Plain per-frame counts, shown below the timings
+enum ProfilerCounter {
+    PRC_Drawn,
+    PRC_Culled,
+    PRC_Hidden, // In cells the camera can't see into, see CellsUpdateVisibility()
+    PRC_Clipped, // Subdivided faces cut by the near plane, see AddSubdividedPolyFT()
+    PRC_TPageSwitches, // Texture page changes in the frame's OT, see CountTPageSwitches()
+    PRC_Composed, // Object transforms composed with the camera's again, see CameraTransformMatrix()
+    PRC_Count
+};
+
+typedef struct ProfilerStats {
+    u_short start;
+    u_short frameTotal; // Sum of every Begin/End pair in the current frame
+
+    u_short windowMin;
+    u_short windowMax;
+    u_long windowSum;
+
+    // Results of the last finished window
+    u_short min;
+    u_short avg;
+    u_short max;
+
+    u_long runSum; // Every frame since the profiler was switched on
+} ProfilerStats;
+
+extern bool profilerEnabled;
+
+#if PROFILER
+void ProfilerInit();
+void ProfilerToggle();
+void ProfilerBegin(enum ProfilerScope scope);
+void ProfilerEnd(enum ProfilerScope scope);
+void ProfilerCount(enum ProfilerCounter counter, u_short amount);
+void ProfilerEndFrame();
+void ProfilerPrint();
+#ifdef HOST
+void ProfilerReport();
+#endif
+#else
+// Arguments still count as used, so values that only feed the profiler don't warn when it's compiled out
+#define ProfilerInit()
+#define ProfilerToggle()
+#define ProfilerBegin(scope) ((void)(scope))
+#define ProfilerEnd(scope) ((void)(scope))
+#define ProfilerCount(counter, amount) ((void)(counter), (void)(amount))
+#define ProfilerEndFrame()
+#define ProfilerPrint()
+#define ProfilerReport()
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#include <stddef.h>
+#include <string.h>
+#include <libgte.h>
+#include <libgpu.h>
+
+#ifdef HOST
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+#include "replay.h"
+
+#ifdef HOST
+// No fixed memory map on the host, recordings go through files instead (PSX_REPLAY_RECORD / PSX_REPLAY_PLAY)
+static Replay hostReplay;
+static Replay* const replay = &hostReplay;
+#else
+static Replay* const replay = (Replay*)REPLAYADDRESS;
+#endif
+
+static enum ReplayMode replayMode = RPM_Off;
+static u_int replayFrame = 0;
+
+// The kernel refreshes the live buffer from the VBLANK interrupt, so each frame works on its own copy
+static u_char frameData[REPLAYPADBYTES];
+
+#ifdef HOST
+static const char* recordPath = NULL;
+
+static void WriteRecording() {
+    FILE* file = fopen(recordPath, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "replay: can't write %s\n", recordPath);
+        return;
+    }
+
+    fwrite(replay, sizeof(ReplayHeader) + replay->header.frameCount * REPLAYPADBYTES, 1, file);
+    fclose(file);
+    printf("replay: recorded %u frames to %s\n", replay->header.frameCount, recordPath);
+}
+
+static void ReadRecording(const char* path) {
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        fprintf(stderr, "replay: can't read %s\n", path);
+        exit(1);
+    }
+
+    memset(replay, 0, sizeof(Replay));
+    size_t size = fread(replay, 1, sizeof(Replay), file);
+    fclose(file);
+
+    // A dump can be longer than the recording in it, but never shorter
+    if (size < sizeof(ReplayHeader) || size < sizeof(ReplayHeader) + replay->header.frameCount * REPLAYPADBYTES) {
+        fprintf(stderr, "replay: %s is truncated\n", path);
+        exit(1);
+    }
+}
+#endif
+
+void ReplayInit(enum ReplayMode mode) {
+#ifdef HOST
+    const char* playPath = getenv("PSX_REPLAY_PLAY");
+    recordPath = getenv("PSX_REPLAY_RECORD");
+
+    if (playPath != NULL) {
+        ReadRecording(playPath);
+        mode = RPM_Playback;
+    }
+    else if (recordPath != NULL) {
+        mode = RPM_Record;
+        atexit(WriteRecording);
+    }
+#endif
+
+    replayMode = mode;
+    replayFrame = 0;
+
+    if (mode == RPM_Record) {
+        replay->header.magic = REPLAYMAGIC;
+        replay->header.frameCount = 0;
+    }
+    // Garbage or an empty recording just leaves the input live
+    else if (mode == RPM_Playback) {
+        if (replay->header.magic != REPLAYMAGIC || replay->header.frameCount > REPLAYMAXFRAMES) {
+            replayMode = RPM_Off;
+        }
+    }
+}
+
+// Returns the pad bytes this frame should run with. Must be called exactly once per frame to stay in step with the recording
+const u_char* ReplayPad(const u_char* liveData) {
+    memcpy(frameData, liveData, REPLAYPADBYTES);
+
+    if (replayMode == RPM_Record) {
+        if (replay->header.frameCount < REPLAYMAXFRAMES) {
+            memcpy(replay->frames[replay->header.frameCount], frameData, REPLAYPADBYTES);
+            replay->header.frameCount++;
+        }
+    }
+    else if (replayMode == RPM_Playback) {
+        if (replayFrame < replay->header.frameCount) {
+            memcpy(frameData, replay->frames[replayFrame], REPLAYPADBYTES);
+            replayFrame++;
+        }
+        else {
+            replayMode = RPM_Off;
+        }
+    }
+
+    return frameData;
+}
+
+void ReplayPrint() {
+    if (replayMode == RPM_Record) {
+        FntPrint("REC  %04d/%04d\n", replay->header.frameCount, REPLAYMAXFRAMES);
+    }
+    else if (replayMode == RPM_Playback) {
+        FntPrint("PLAY %04d/%04d\n", replayFrame, replay->header.frameCount);
+    }
+}
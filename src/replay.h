@@ -0,0 +1,42 @@
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <libgte.h>
+
+// The first 8 bytes of a pad's data buffer are everything UpdatePad() reads: status, type, buttons and both sticks
+#define REPLAYPADBYTES 8
+#define REPLAYMAXFRAMES 7200 // Two minutes at 60 Hz, ~56 KB
+
+// The recording lives at a fixed address just past the heap (see InitHeap() in main.c), so a dump taken from one build
+// can be loaded straight back into memory under a different build with the emulator's memory tools
+#define REPLAYADDRESS 0x80080000
+
+#define REPLAYMAGIC 0x594c5052 // "RPLY" in little endian
+
+// Which mode the game boots in. Can be overridden from the build, e.g. CPPFLAGS += -DREPLAYMODE=RPM_Record
+#ifndef REPLAYMODE
+#define REPLAYMODE RPM_Off
+#endif
+
+enum ReplayMode {
+    RPM_Off,      // Live input, nothing stored
+    RPM_Record,   // Live input, every frame appended to the recording until it's full
+    RPM_Playback  // Input comes from the recording, falls back to live input after its last frame
+};
+
+// Laid out with fixed-size fields so a dump from the console reads the same on the host build
+typedef struct ReplayHeader {
+    u_int magic;
+    u_int frameCount;
+} ReplayHeader;
+
+typedef struct Replay {
+    ReplayHeader header;
+    u_char frames[REPLAYMAXFRAMES][REPLAYPADBYTES];
+} Replay;
+
+void ReplayInit(enum ReplayMode mode);
+const u_char* ReplayPad(const u_char* liveData);
+void ReplayPrint();
+
+#endif
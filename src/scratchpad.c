@@ -0,0 +1,40 @@
+#include <assert.h>
+#include <stddef.h>
+#include <libgte.h>
+
+#include "scratchpad.h"
+
+#if USESCRATCHPAD
+#ifdef HOST
+// No scratchpad on the host. The stand-in is just as big, so a layout that fits here fits the console too
+static long hostScratchpad[SCRATCHPADSIZE / sizeof(long)];
+static char* const scratchpad = (char*)hostScratchpad;
+#else
+static char* const scratchpad = (char*)SCRATCHPADADDRESS;
+#endif
+#endif
+
+static size_t scratchpadUsed = 0;
+
+// Claims size bytes of the scratchpad for the rest of the program, aligned for longs
+// Everything claimed has to fit, running out means the scratchpad layout is wrong and is asserted on
+// Returns NULL if the scratchpad is switched off, callers keep a main RAM copy to fall back to
+void* ScratchpadAlloc(size_t size) {
+#if USESCRATCHPAD
+    size = (size + sizeof(long) - 1) & ~(sizeof(long) - 1);
+    assert(scratchpadUsed + size <= SCRATCHPADSIZE);
+
+    void* block = scratchpad + scratchpadUsed;
+    scratchpadUsed += size;
+
+    return block;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+// Bytes claimed so far
+size_t ScratchpadUsed() {
+    return scratchpadUsed;
+}
@@ -0,0 +1,20 @@
+#ifndef __SCRATCHPAD_H
+#define __SCRATCHPAD_H
+
+#include <stddef.h>
+
+// The R3000's data cache is mapped as 1 KB of fast RAM at 0x1F800000 instead of caching anything
+// Reads and writes there take a single cycle, where main RAM stalls the CPU for several
+#define SCRATCHPADADDRESS 0x1F800000
+#define SCRATCHPADSIZE 1024
+
+// 1 = hot draw data lives in the scratchpad, 0 = every ScratchpadAlloc() fails and callers use their main RAM copies
+// Can be overridden from the build to compare both with the profiler, e.g. CPPFLAGS += -DUSESCRATCHPAD=0
+#ifndef USESCRATCHPAD
+#define USESCRATCHPAD 1
+#endif
+
+void* ScratchpadAlloc(size_t size);
+size_t ScratchpadUsed();
+
+#endif
@@ -0,0 +1,191 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "vram.h"
+
+// Row of images inside a texture page, packed left to right
+typedef struct VramShelf {
+    short y;      // Relative to the page
+    short height;
+    short used;   // Words taken from the left
+} VramShelf;
+
+typedef struct VramPage {
+    bool reserved; // Overlaps something that isn't an image, e.g. a framebuffer
+    u_char shelfCount;
+    short top;     // First row no shelf has claimed yet
+    VramShelf shelves[VRAMMAXSHELVES];
+} VramPage;
+
+// Rows CLUTs are packed into, they are one word high and don't have to stay inside a texture page
+typedef struct VramClutArea {
+    RECT rect;
+    short x; // Next free word, relative to the area
+    short y;
+} VramClutArea;
+
+static VramPage pages[VRAMPAGES];
+static VramClutArea clutAreas[VRAMMAXCLUTAREAS];
+static size_t clutAreaCount = 0;
+static u_long allocatedBytes = 0;
+
+static short AlignUp(short value, short align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+static short PowerOfTwo(short value) {
+    short p = 1;
+
+    while (p < value) {
+        p <<= 1;
+    }
+
+    return p;
+}
+
+static bool Overlaps(const RECT* a, const RECT* b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static void PageRect(size_t page, RECT* rect) {
+    setRECT(rect, (page % VRAMPAGECOLUMNS) * VRAMPAGEWIDTH, (page / VRAMPAGECOLUMNS) * VRAMPAGEHEIGHT, VRAMPAGEWIDTH, VRAMPAGEHEIGHT);
+}
+
+// Forgets every reservation and allocation, call before loading a new set of textures
+void VramInit() {
+    memset(pages, 0, sizeof(pages));
+    clutAreaCount = 0;
+    allocatedBytes = 0;
+}
+
+// Keeps images out of every texture page rect touches, for framebuffers and the debug font
+void VramReserve(const RECT* rect) {
+    RECT pageRect;
+
+    for (size_t i = 0; i < VRAMPAGES; i++) {
+        PageRect(i, &pageRect);
+
+        if (Overlaps(rect, &pageRect)) {
+            pages[i].reserved = true;
+        }
+    }
+}
+
+// Hands rect over to CLUTs, e.g. the rows a framebuffer leaves unused in its reserved pages
+void VramAddClutArea(const RECT* rect) {
+    if (clutAreaCount < VRAMMAXCLUTAREAS) {
+        clutAreas[clutAreaCount].rect = *rect;
+        clutAreas[clutAreaCount].x = 0;
+        clutAreas[clutAreaCount].y = 0;
+        clutAreaCount++;
+    }
+}
+
+static void PlaceOnShelf(size_t page, VramShelf* shelf, short x, RECT* rect) {
+    RECT pageRect;
+
+    PageRect(page, &pageRect);
+    rect->x = pageRect.x + x;
+    rect->y = pageRect.y + shelf->y;
+
+    shelf->used = x + rect->w;
+    allocatedBytes += rect->w * rect->h * 2;
+}
+
+// Finds a spot for an image of rect->w x rect->h words that doesn't cross a texture page and sets rect->x and y to it
+// Images are aligned to their size rounded up to a power of two, so texture windows over them still line up
+// Returns false if there is no room left, rect is left as it was
+bool VramAllocImage(RECT* rect) {
+    if (rect->w <= 0 || rect->h <= 0 || rect->w > VRAMPAGEWIDTH || rect->h > VRAMPAGEHEIGHT) {
+        return false;
+    }
+
+    short xAlign = PowerOfTwo(rect->w);
+    short yAlign = PowerOfTwo(rect->h);
+
+    // Fill up the shelves already there before starting new ones
+    for (size_t i = 0; i < VRAMPAGES; i++) {
+        VramPage* page = &pages[i];
+
+        for (size_t s = 0; s < page->shelfCount; s++) {
+            VramShelf* shelf = &page->shelves[s];
+            short x = AlignUp(shelf->used, xAlign);
+
+            // The shelf's y was only aligned for the images already on it, a taller one may need more
+            if (shelf->height >= rect->h && shelf->y % yAlign == 0 && x + rect->w <= VRAMPAGEWIDTH) {
+                PlaceOnShelf(i, shelf, x, rect);
+                return true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < VRAMPAGES; i++) {
+        VramPage* page = &pages[i];
+        short y = AlignUp(page->top, yAlign);
+
+        if (page->reserved || page->shelfCount >= VRAMMAXSHELVES || y + rect->h > VRAMPAGEHEIGHT) {
+            continue;
+        }
+
+        VramShelf* shelf = &page->shelves[page->shelfCount++];
+        shelf->y = y;
+        shelf->height = rect->h;
+        shelf->used = 0;
+        page->top = y + rect->h;
+
+        PlaceOnShelf(i, shelf, 0, rect);
+        return true;
+    }
+
+    return false;
+}
+
+// Same as VramAllocImage() for a CLUT of rect->w entries
+bool VramAllocClut(RECT* rect) {
+    if (rect->h != 1) {
+        return false;
+    }
+
+    for (size_t i = 0; i < clutAreaCount; i++) {
+        VramClutArea* area = &clutAreas[i];
+
+        if (rect->w > area->rect.w) {
+            continue;
+        }
+
+        while (area->y < area->rect.h) {
+            short x = AlignUp(area->rect.x + area->x, VRAMCLUTALIGN);
+
+            if (x + rect->w <= area->rect.x + area->rect.w) {
+                rect->x = x;
+                rect->y = area->rect.y + area->y;
+
+                area->x = x + rect->w - area->rect.x;
+                allocatedBytes += rect->w * 2;
+                return true;
+            }
+
+            area->x = 0;
+            area->y++;
+        }
+    }
+
+    return false;
+}
+
+// Bytes of image and CLUT space that haven't been handed out yet, leftovers at the end of shelves included
+u_long VramFreeBytes() {
+    u_long total = 0;
+
+    for (size_t i = 0; i < VRAMPAGES; i++) {
+        if (!pages[i].reserved) {
+            total += VRAMPAGEWIDTH * VRAMPAGEHEIGHT * 2;
+        }
+    }
+
+    for (size_t i = 0; i < clutAreaCount; i++) {
+        total += clutAreas[i].rect.w * clutAreas[i].rect.h * 2;
+    }
+
+    return total - allocatedBytes;
+}
@@ -0,0 +1,26 @@
+#ifndef __VRAM_H
+#define __VRAM_H
+
+#include <stdbool.h>
+#include <libgte.h>
+#include <libgpu.h>
+
+// VRAM is 1024x512 16-bit words, split into texture pages a textured primitive can address through its tpage
+#define VRAMWIDTH 1024
+#define VRAMHEIGHT 512
+#define VRAMPAGEWIDTH 64   // In VRAM words, that's 256 texels at 4 bit, 128 at 8 bit, 64 at 16 bit
+#define VRAMPAGEHEIGHT 256
+#define VRAMPAGECOLUMNS (VRAMWIDTH / VRAMPAGEWIDTH)
+#define VRAMPAGES (VRAMPAGECOLUMNS * (VRAMHEIGHT / VRAMPAGEHEIGHT))
+#define VRAMMAXSHELVES 8      // Per texture page
+#define VRAMMAXCLUTAREAS 2
+#define VRAMCLUTALIGN 16      // CLUTs have to start on a multiple of 16 words
+
+void VramInit();
+void VramReserve(const RECT* rect);
+void VramAddClutArea(const RECT* rect);
+bool VramAllocImage(RECT* rect);
+bool VramAllocClut(RECT* rect);
+u_long VramFreeBytes();
+
+#endif
@@ -0,0 +1,133 @@
+// Host-side benchmark comparing the collision grid against the linear box scan it replaced
+// Build and run with: make colgridbench && ./colgridbench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "colgrid.h"
+
+#define QUERYCOUNT 200000
+#define PLAYERWIDTH 40
+#define PLAYERHEIGHT 48
+
+// Same layout as the relevant parts of StaticCollisionPolyBox: position of the low corner plus dimensions, Y up is negative
+typedef struct BenchBox {
+    long x, y, z;
+    long w, h, d;
+} BenchBox;
+
+typedef struct BenchQuery {
+    long minX, minY, minZ;
+    long maxX, maxY, maxZ;
+} BenchQuery;
+
+// Mirrors ScanForOverlaps() in main.c, all three axes have to overlap
+static int Overlaps(const BenchQuery* q, const BenchBox* box) {
+    return q->minX < box->x + box->w && q->maxX > box->x
+        && q->minY > box->y - box->h && q->maxY < box->y
+        && q->minZ < box->z + box->d && q->maxZ > box->z;
+}
+
+static double Seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void RunBenchmark(size_t boxCount) {
+    // Level grows with the box count, so box density stays the same
+    long side = 256;
+    while ((side / 256) * (side / 256) < (long)boxCount) {
+        side += 256;
+    }
+
+    BenchBox* boxes = malloc(boxCount * sizeof(BenchBox));
+    ColGridBounds* bounds = malloc(boxCount * sizeof(ColGridBounds));
+    BenchQuery* queries = malloc(QUERYCOUNT * sizeof(BenchQuery));
+    unsigned short results[64];
+    ColGrid grid;
+
+    for (size_t i = 0; i < boxCount; i++) {
+        boxes[i].x = rand() % side;
+        boxes[i].z = rand() % side;
+        boxes[i].y = -(rand() % 128);
+        boxes[i].w = 32 + rand() % 96;
+        boxes[i].d = 32 + rand() % 96;
+        boxes[i].h = 16 + rand() % 112;
+
+        bounds[i].minX = boxes[i].x;
+        bounds[i].minZ = boxes[i].z;
+        bounds[i].maxX = boxes[i].x + boxes[i].w;
+        bounds[i].maxZ = boxes[i].z + boxes[i].d;
+    }
+
+    for (size_t i = 0; i < QUERYCOUNT; i++) {
+        long x = rand() % side;
+        long y = -(rand() % 128);
+        long z = rand() % side;
+
+        queries[i].minX = x - PLAYERWIDTH / 2;
+        queries[i].maxX = x + PLAYERWIDTH / 2;
+        queries[i].minY = y;
+        queries[i].maxY = y - PLAYERHEIGHT;
+        queries[i].minZ = z - PLAYERWIDTH / 2;
+        queries[i].maxZ = z + PLAYERWIDTH / 2;
+    }
+
+    double buildStart = Seconds();
+    ColGridBuild(&grid, bounds, boxCount);
+    double buildTime = Seconds() - buildStart;
+
+    size_t linearHits = 0;
+    double linearStart = Seconds();
+
+    for (size_t q = 0; q < QUERYCOUNT; q++) {
+        for (size_t i = 0; i < boxCount; i++) {
+            linearHits += Overlaps(&queries[q], &boxes[i]);
+        }
+    }
+
+    double linearTime = Seconds() - linearStart;
+
+    size_t gridHits = 0;
+    size_t gridCandidates = 0;
+    double gridStart = Seconds();
+
+    for (size_t q = 0; q < QUERYCOUNT; q++) {
+        size_t count = ColGridQuery(&grid, queries[q].minX, queries[q].minZ, queries[q].maxX, queries[q].maxZ, results, 64);
+        gridCandidates += count;
+        count = (count > 64) ? 64 : count;
+
+        for (size_t c = 0; c < count; c++) {
+            gridHits += Overlaps(&queries[q], &boxes[results[c]]);
+        }
+    }
+
+    double gridTime = Seconds() - gridStart;
+
+    printf("%5zu boxes | grid %3ux%-3u cell %4d | build %7.1f us | linear %7.1f ns/query | grid %6.1f ns/query (%4.1f candidates) | speedup %6.1fx | %s\n",
+        boxCount, grid.cellsX, grid.cellsZ, 1 << grid.cellShift,
+        buildTime * 1e6,
+        linearTime * 1e9 / QUERYCOUNT,
+        gridTime * 1e9 / QUERYCOUNT, (double)gridCandidates / QUERYCOUNT,
+        linearTime / gridTime,
+        linearHits == gridHits ? "hits match" : "HIT MISMATCH");
+
+    ColGridFree(&grid);
+    free(boxes);
+    free(bounds);
+    free(queries);
+}
+
+int main(void) {
+    const size_t boxCounts[] = { 10, 100, 1000 };
+
+    srand(0);
+
+    for (size_t i = 0; i < sizeof(boxCounts) / sizeof(*boxCounts); i++) {
+        RunBenchmark(boxCounts[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,1289 @@
+// Host-side level compiler. Turns a text scene description (see levels/testlevel.txt) into the binary format in level.h
+// Everything the console used to work out at boot is done here: primitive templates with their tpage, clut and UVs,
+// the subdivided UVs of multi polys, bounding spheres and the collision grid
+// Build and run with: make levelc && ./levelc levels/testlevel.txt levels/testlevel.lvl
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "colgrid.h"
+#include "level.h"
+
+#define MAXLINE 8192
+#define MAXTOKENS 1024
+#define MAXNAME 32
+#define MAXNAMED 256
+#define MAXTEXTURES LEVELNOTEXTURE
+#define MAXVERTICES 8192
+#define MAXINDICES 16384
+#define MAXMATERIALS 1024
+#define MAXOBJECTS 1024
+#define MAXPOLYS 8192
+#define MAXLODS 1024
+#define MAXCELLS LEVELOUTSIDE
+#define MAXPORTALS 1024
+#define MAXFACES 8192
+
+// Primitive lengths and codes, as set by the PsyQ setPolyF4() and setPolyFT4() macros
+#define POLYF4LEN 5
+#define POLYF4CODE 0x28
+#define POLYFT4LEN 9
+#define POLYFT4CODE 0x2C
+
+// Same as the PsyQ macros of the same names
+#define getTPage(tp, abr, x, y) \
+    ((((tp) & 0x3) << 7) | (((abr) & 0x3) << 5) | (((y) & 0x100) >> 4) | (((x) & 0x3ff) >> 6) | (((y) & 0x200) << 2))
+#define getClut(x, y) (((y) << 6) | (((x) >> 4) & 0x3f))
+
+// The console reads these straight out of the file, so their sizes must not drift
+typedef char HeaderSizeCheck[(sizeof(LevelHeader) == 80) ? 1 : -1];
+typedef char ObjectSizeCheck[(sizeof(LevelObject) == 44) ? 1 : -1];
+typedef char MaterialSizeCheck[(sizeof(LevelMaterial) == 12) ? 1 : -1];
+typedef char PolyF4SizeCheck[(sizeof(LevelPolyF4) == 24) ? 1 : -1];
+typedef char PolyFT4SizeCheck[(sizeof(LevelPolyFT4) == 40) ? 1 : -1];
+typedef char LodSizeCheck[(sizeof(LevelLod) == 12) ? 1 : -1];
+typedef char CellSizeCheck[(sizeof(LevelCell) == 12) ? 1 : -1];
+typedef char PortalSizeCheck[(sizeof(LevelPortal) == 28) ? 1 : -1];
+
+typedef struct Vertex {
+    short vx, vy, vz, pad;
+} Vertex;
+
+typedef struct Texture {
+    char name[MAXNAME];
+    u_short tpage;
+    u_short clut;
+} Texture;
+
+// Named vertex and index lists only go into the pools once an object uses them
+typedef struct NamedList {
+    char name[MAXNAME];
+    int* values;
+    int count;
+} NamedList;
+
+typedef struct NamedMaterial {
+    char name[MAXNAME];
+    LevelMaterial material;
+} NamedMaterial;
+
+static const char* sourcePath = NULL;
+static int lineNumber = 0;
+
+static Texture textures[MAXTEXTURES];
+static int textureCount = 0;
+static NamedList vertexLists[MAXNAMED];
+static int vertexListCount = 0;
+static NamedList indexLists[MAXNAMED];
+static int indexListCount = 0;
+static NamedMaterial namedMaterials[MAXNAMED];
+static int namedMaterialCount = 0;
+
+static Vertex vertexPool[MAXVERTICES];
+static int vertexCount = 0;
+static u_int indexPool[MAXINDICES];
+static int indexCount = 0;
+static LevelMaterial materialTable[MAXMATERIALS];
+static int materialCount = 0;
+static LevelObject objects[MAXOBJECTS];
+static int objectCount = 0;
+static LevelPolyF4 polyF4s[MAXPOLYS];
+static int polyF4Count = 0;
+static LevelPolyFT4 polyFT4s[MAXPOLYS];
+static int polyFT4Count = 0;
+static LevelLod lods[MAXLODS];
+static int lodCount = 0;
+static LevelCell cells[MAXCELLS];
+static char cellNames[MAXCELLS][MAXNAME];
+static int cellCount = 0;
+static LevelPortal portals[MAXPORTALS];
+static int portalCount = 0;
+static u_short faces[MAXFACES];
+static int faceCount = 0;
+static ColGridBounds gridBoxes[MAXOBJECTS];
+static int gridBoxCount = 0;
+
+static const int cubeIndices[] = {
+    0, 1, 2, 3,
+    1, 5, 6, 2,
+    5, 4, 7, 6,
+    4, 0, 3, 7,
+    4, 5, 1, 0,
+    6, 7, 3, 2
+};
+
+static void Fail(const char* format, ...) {
+    va_list args;
+
+    fprintf(stderr, "%s:%d: ", sourcePath, lineNumber);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    exit(1);
+}
+
+// ---- Parsing ----
+
+// Reads one logical line, joining lines that end in a backslash and dropping # comments
+static bool ReadLine(FILE* file, char* line) {
+    size_t length = 0;
+    char part[MAXLINE];
+    bool any = false;
+
+    line[0] = '\0';
+
+    while (fgets(part, sizeof(part), file) != NULL) {
+        lineNumber++;
+        any = true;
+
+        char* comment = strchr(part, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        size_t partLength = strlen(part);
+        while (partLength > 0 && (part[partLength - 1] == '\n' || part[partLength - 1] == '\r' || part[partLength - 1] == ' ' || part[partLength - 1] == '\t')) {
+            partLength--;
+        }
+
+        bool continues = partLength > 0 && part[partLength - 1] == '\\';
+        if (continues) {
+            partLength--;
+        }
+
+        if (length + partLength + 2 > MAXLINE) {
+            Fail("line too long");
+        }
+
+        memcpy(line + length, part, partLength);
+        length += partLength;
+        line[length++] = ' ';
+        line[length] = '\0';
+
+        if (!continues) {
+            break;
+        }
+    }
+
+    return any;
+}
+
+static int Tokenise(char* line, char** tokens) {
+    int count = 0;
+
+    for (char* token = strtok(line, " \t"); token != NULL; token = strtok(NULL, " \t")) {
+        if (count == MAXTOKENS) {
+            Fail("too many values on one line");
+        }
+
+        tokens[count++] = token;
+    }
+
+    return count;
+}
+
+static int ParseInt(const char* text) {
+    char* end;
+    long value = strtol(text, &end, 0);
+
+    if (end == text || *end != '\0') {
+        Fail("'%s' is not a number", text);
+    }
+
+    return (int)value;
+}
+
+// Parses a separator-delimited list of numbers, e.g. "0,-24,256"
+static int ParseList(const char* text, char separator, int* values, int maxValues) {
+    char buffer[MAXLINE];
+    int count = 0;
+    char* start = buffer;
+
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    while (1) {
+        char* end = strchr(start, separator);
+
+        if (end != NULL) {
+            *end = '\0';
+        }
+
+        if (count == maxValues) {
+            Fail("too many values in '%s'", text);
+        }
+
+        values[count++] = ParseInt(start);
+
+        if (end == NULL) {
+            break;
+        }
+
+        start = end + 1;
+    }
+
+    return count;
+}
+
+static void ParseExact(const char* text, int* values, int expected) {
+    if (ParseList(text, ',', values, expected) != expected) {
+        Fail("'%s' needs %d values", text, expected);
+    }
+}
+
+// Finds key=value among the tokens of an object line. Returns NULL if the key isn't there and isn't required
+static const char* Value(char** tokens, int tokenCount, const char* key, bool required) {
+    size_t keyLength = strlen(key);
+
+    for (int i = 1; i < tokenCount; i++) {
+        if (strncmp(tokens[i], key, keyLength) == 0 && tokens[i][keyLength] == '=') {
+            return tokens[i] + keyLength + 1;
+        }
+    }
+
+    if (required) {
+        Fail("%s needs %s=", tokens[0], key);
+    }
+
+    return NULL;
+}
+
+static void CopyName(char* destination, const char* name) {
+    if (strlen(name) >= MAXNAME) {
+        Fail("name '%s' is too long", name);
+    }
+
+    strcpy(destination, name);
+}
+
+static u_short Read16(const u_char* bytes) {
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static u_int Read32(const u_char* bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((u_int)bytes[3] << 24);
+}
+
+// Only the header and block positions of a TIM are needed to resolve tpage and clut
+static void AddTexture(const char* name, const char* path) {
+    u_char header[8];
+    u_char block[12];
+    u_int clutX = 0;
+    u_int clutY = 0;
+    FILE* file = fopen(path, "rb");
+
+    if (textureCount == MAXTEXTURES) {
+        Fail("too many textures");
+    }
+    if (file == NULL) {
+        Fail("can't open %s", path);
+    }
+
+    if (fread(header, sizeof(header), 1, file) != 1 || Read32(header) != 0x10) {
+        Fail("%s is not a TIM", path);
+    }
+
+    u_int mode = Read32(header + 4);
+
+    if (mode & 0x8) {
+        if (fread(block, sizeof(block), 1, file) != 1) {
+            Fail("%s is truncated", path);
+        }
+
+        clutX = Read16(block + 4);
+        clutY = Read16(block + 6);
+        fseek(file, Read32(block) - sizeof(block), SEEK_CUR);
+    }
+
+    if (fread(block, sizeof(block), 1, file) != 1) {
+        Fail("%s is truncated", path);
+    }
+
+    fclose(file);
+
+    Texture* texture = &textures[textureCount++];
+    CopyName(texture->name, name);
+    texture->tpage = getTPage(mode & 0x3, 0, Read16(block + 4), Read16(block + 6));
+    texture->clut = getClut(clutX, clutY);
+}
+
+static int FindTexture(const char* name) {
+    for (int i = 0; i < textureCount; i++) {
+        if (strcmp(textures[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    Fail("unknown texture '%s'", name);
+    return -1;
+}
+
+static void AddNamedList(NamedList* lists, int* listCount, char** tokens, int tokenCount, int valuesPerEntry) {
+    if (tokenCount < 3) {
+        Fail("%s needs a name and values", tokens[0]);
+    }
+    if (*listCount == MAXNAMED) {
+        Fail("too many %s lists", tokens[0]);
+    }
+    if ((tokenCount - 2) % valuesPerEntry != 0) {
+        Fail("%s '%s' needs %d values per entry", tokens[0], tokens[1], valuesPerEntry);
+    }
+
+    NamedList* list = &lists[(*listCount)++];
+    CopyName(list->name, tokens[1]);
+    list->count = tokenCount - 2;
+    list->values = malloc(list->count * sizeof(int));
+
+    for (int i = 0; i < list->count; i++) {
+        list->values[i] = ParseInt(tokens[2 + i]);
+    }
+}
+
+// box <name> x0 y0 z0 x1 y1 z1 is shorthand for the 8 corners, in the order cubeIndices expects
+static void AddBoxList(char** tokens, int tokenCount) {
+    int c[6];
+
+    if (tokenCount != 8) {
+        Fail("box needs a name and 6 values");
+    }
+    if (vertexListCount == MAXNAMED) {
+        Fail("too many vertex lists");
+    }
+
+    for (int i = 0; i < 6; i++) {
+        c[i] = ParseInt(tokens[2 + i]);
+    }
+
+    int corners[24] = {
+        c[0], c[1], c[2], c[3], c[1], c[2], c[3], c[4], c[2], c[0], c[4], c[2],
+        c[0], c[1], c[5], c[3], c[1], c[5], c[3], c[4], c[5], c[0], c[4], c[5]
+    };
+
+    NamedList* list = &vertexLists[vertexListCount++];
+    CopyName(list->name, tokens[1]);
+    list->count = 24;
+    list->values = malloc(sizeof(corners));
+    memcpy(list->values, corners, sizeof(corners));
+}
+
+static const NamedList* FindList(const NamedList* lists, int listCount, const char* name) {
+    for (int i = 0; i < listCount; i++) {
+        if (strcmp(lists[i].name, name) == 0) {
+            return &lists[i];
+        }
+    }
+
+    Fail("unknown list '%s'", name);
+    return NULL;
+}
+
+static void AddMaterialDefinition(char** tokens, int tokenCount) {
+    int values[4];
+
+    if (tokenCount < 3) {
+        Fail("material needs a name and a texture");
+    }
+    if (namedMaterialCount == MAXNAMED) {
+        Fail("too many materials");
+    }
+
+    NamedMaterial* named = &namedMaterials[namedMaterialCount++];
+    LevelMaterial* material = &named->material;
+    CopyName(named->name, tokens[1]);
+
+    material->texture = FindTexture(tokens[2]);
+    material->r = material->g = material->b = 128;
+
+    const char* text = Value(tokens + 1, tokenCount - 1, "uv", true);
+    ParseExact(text, values, 4);
+    material->u0 = values[0];
+    material->v0 = values[1];
+    material->uvwidth = values[2];
+    material->uvheight = values[3];
+
+    if ((text = Value(tokens + 1, tokenCount - 1, "window", false)) != NULL) {
+        ParseExact(text, values, 4);
+        material->twx = values[0];
+        material->twy = values[1];
+        material->tww = values[2];
+        material->twh = values[3];
+    }
+
+    if ((text = Value(tokens + 1, tokenCount - 1, "rgb", false)) != NULL) {
+        ParseExact(text, values, 3);
+        material->r = values[0];
+        material->g = values[1];
+        material->b = values[2];
+    }
+}
+
+static const LevelMaterial* FindMaterial(const char* name) {
+    for (int i = 0; i < namedMaterialCount; i++) {
+        if (strcmp(namedMaterials[i].name, name) == 0) {
+            return &namedMaterials[i].material;
+        }
+    }
+
+    Fail("unknown material '%s'", name);
+    return NULL;
+}
+
+// ---- Pools ----
+
+// Identical runs already in the pool are reused, so shapes shared between objects are only stored once
+static int AddVertices(const Vertex* vertices, int count) {
+    for (int start = 0; start + count <= vertexCount; start++) {
+        if (memcmp(&vertexPool[start], vertices, count * sizeof(Vertex)) == 0) {
+            return start;
+        }
+    }
+
+    if (vertexCount + count > MAXVERTICES) {
+        Fail("too many vertices");
+    }
+
+    memcpy(&vertexPool[vertexCount], vertices, count * sizeof(Vertex));
+    vertexCount += count;
+
+    return vertexCount - count;
+}
+
+static int AddIndices(const u_int* indices, int count) {
+    for (int start = 0; start + count <= indexCount; start++) {
+        if (memcmp(&indexPool[start], indices, count * sizeof(u_int)) == 0) {
+            return start;
+        }
+    }
+
+    if (indexCount + count > MAXINDICES) {
+        Fail("too many indices");
+    }
+
+    memcpy(&indexPool[indexCount], indices, count * sizeof(u_int));
+    indexCount += count;
+
+    return indexCount - count;
+}
+
+static int AddMaterial(const LevelMaterial* material) {
+    for (int i = 0; i < materialCount; i++) {
+        if (memcmp(&materialTable[i], material, sizeof(LevelMaterial)) == 0) {
+            return i;
+        }
+    }
+
+    if (materialCount == MAXMATERIALS) {
+        Fail("too many materials");
+    }
+
+    materialTable[materialCount] = *material;
+
+    return materialCount++;
+}
+
+static int UseVertexList(const NamedList* list, Vertex* out) {
+    Vertex vertices[MAXTOKENS / 3];
+    int count = list->count / 3;
+
+    for (int i = 0; i < count; i++) {
+        vertices[i].vx = list->values[(i * 3) + 0];
+        vertices[i].vy = list->values[(i * 3) + 1];
+        vertices[i].vz = list->values[(i * 3) + 2];
+        vertices[i].pad = 0;
+    }
+
+    if (out != NULL) {
+        memcpy(out, vertices, count * sizeof(Vertex));
+    }
+
+    return AddVertices(vertices, count);
+}
+
+static int UseIndexList(const int* values, int count, int vertexListSize) {
+    u_int indices[MAXTOKENS];
+
+    for (int i = 0; i < count; i++) {
+        if (values[i] < 0 || values[i] >= vertexListSize) {
+            Fail("index %d is outside of the vertex list", values[i]);
+        }
+
+        indices[i] = values[i];
+    }
+
+    return AddIndices(indices, count);
+}
+
+// ---- Objects ----
+
+static LevelPolyFT4* AddPolyFT4(const LevelMaterial* material, int u0, int v0, int uvwidth, int uvheight) {
+    if (polyFT4Count == MAXPOLYS) {
+        Fail("too many textured faces");
+    }
+
+    LevelPolyFT4* poly = &polyFT4s[polyFT4Count++];
+    memset(poly, 0, sizeof(LevelPolyFT4));
+
+    poly->tag = POLYFT4LEN << 24;
+    poly->code = POLYFT4CODE;
+    poly->r0 = material->r;
+    poly->g0 = material->g;
+    poly->b0 = material->b;
+    poly->tpage = textures[material->texture].tpage;
+    poly->clut = textures[material->texture].clut;
+
+    // Same as setUVWH(), including wrapping at 256
+    poly->u0 = u0;
+    poly->v0 = v0;
+    poly->u1 = u0 + uvwidth;
+    poly->v1 = v0;
+    poly->u2 = u0;
+    poly->v2 = v0 + uvheight;
+    poly->u3 = u0 + uvwidth;
+    poly->v3 = v0 + uvheight;
+
+    return poly;
+}
+
+static void FitBounds(LevelObject* lobj, Vertex mins, Vertex maxs) {
+    long dx = maxs.vx - mins.vx;
+    long dy = maxs.vy - mins.vy;
+    long dz = maxs.vz - mins.vz;
+    long squared = dx * dx + dy * dy + dz * dz;
+    long root = 0;
+
+    // Integer square root rounding down, like SquareRoot0()
+    while ((root + 1) * (root + 1) <= squared) {
+        root++;
+    }
+
+    long radius = (root / 2) + 1;
+
+    if (radius > 0xFFFF) {
+        Fail("object is too large");
+    }
+
+    lobj->boundsCentre[0] = (mins.vx + maxs.vx) / 2;
+    lobj->boundsCentre[1] = (mins.vy + maxs.vy) / 2;
+    lobj->boundsCentre[2] = (mins.vz + maxs.vz) / 2;
+    lobj->boundsRadius = radius;
+}
+
+static void FitBoundsToIndices(LevelObject* lobj, int count, int extendX) {
+    const Vertex* vertices = &vertexPool[lobj->firstVertex];
+    const u_int* indices = &indexPool[lobj->firstIndex];
+    Vertex mins = vertices[indices[0]];
+    Vertex maxs = vertices[indices[0]];
+
+    for (int i = 1; i < count; i++) {
+        const Vertex* v = &vertices[indices[i]];
+
+        if (v->vx < mins.vx) mins.vx = v->vx;
+        if (v->vy < mins.vy) mins.vy = v->vy;
+        if (v->vz < mins.vz) mins.vz = v->vz;
+        if (v->vx > maxs.vx) maxs.vx = v->vx;
+        if (v->vy > maxs.vy) maxs.vy = v->vy;
+        if (v->vz > maxs.vz) maxs.vz = v->vz;
+    }
+
+    maxs.vx += extendX;
+    FitBounds(lobj, mins, maxs);
+}
+
+static u_char ParseFlags(const char* text) {
+    static const char* names[] = { "static", "collides", "repeating", "reverse", "autorotate", "batch", "subdivide" };
+    char buffer[MAXLINE];
+    u_char flags = 0;
+
+    if (text == NULL) {
+        return 0;
+    }
+
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char* flag = strtok(buffer, ","); flag != NULL; flag = strtok(NULL, ",")) {
+        size_t i;
+
+        for (i = 0; i < sizeof(names) / sizeof(*names); i++) {
+            if (strcmp(flag, names[i]) == 0) {
+                flags |= 1 << i;
+                break;
+            }
+        }
+
+        if (i == sizeof(names) / sizeof(*names)) {
+            Fail("unknown flag '%s'", flag);
+        }
+    }
+
+    return flags;
+}
+
+static u_char ParsePriority(const char* text) {
+    if (text == NULL || strcmp(text, "neutral") == 0) {
+        return 0;
+    }
+    if (strcmp(text, "low") == 0) {
+        return 1;
+    }
+    if (strcmp(text, "high") == 0) {
+        return 2;
+    }
+
+    Fail("unknown priority '%s'", text);
+    return 0;
+}
+
+static int ParseCount(char** tokens, int tokenCount, const char* key) {
+    int count = ParseInt(Value(tokens, tokenCount, key, true));
+
+    if (count <= 0 || count > 0xFFFF) {
+        Fail("%s has to be between 1 and 65535", key);
+    }
+
+    return count;
+}
+
+// A cell's name, or outside for the space no cell covers
+static u_char FindCell(const char* name) {
+    if (strcmp(name, "outside") == 0) {
+        return LEVELOUTSIDE;
+    }
+
+    for (int i = 0; i < cellCount; i++) {
+        if (strcmp(cellNames[i], name) == 0) {
+            return i;
+        }
+    }
+
+    Fail("unknown cell '%s'", name);
+    return LEVELNOCELL;
+}
+
+// Fields every object line shares: position, rotation, draw priority, flags and cell
+static LevelObject* AddObject(enum LevelObjectType type, char** tokens, int tokenCount) {
+    int values[3];
+
+    if (objectCount == MAXOBJECTS) {
+        Fail("too many objects");
+    }
+
+    LevelObject* lobj = &objects[objectCount++];
+    memset(lobj, 0, sizeof(LevelObject));
+
+    lobj->type = type;
+    lobj->polySides = 4;
+    lobj->flags = ParseFlags(Value(tokens, tokenCount, "flags", false));
+    lobj->drPrio = ParsePriority(Value(tokens, tokenCount, "prio", false));
+    lobj->cell = LEVELNOCELL;
+
+    const char* cell = Value(tokens, tokenCount, "cell", false);
+    if (cell != NULL) {
+        // Cells are only looked up at load, objects that move would leave theirs behind
+        if (type != LOT_ColBox && !(lobj->flags & LOF_Static)) {
+            Fail("only static objects and colboxes can be in a cell");
+        }
+
+        lobj->cell = FindCell(cell);
+    }
+
+    ParseExact(Value(tokens, tokenCount, "pos", true), values, 3);
+    lobj->position[0] = values[0];
+    lobj->position[1] = values[1];
+    lobj->position[2] = values[2];
+
+    const char* rotation = Value(tokens, tokenCount, "rot", false);
+    if (rotation != NULL) {
+        ParseExact(rotation, values, 3);
+        lobj->rotation[0] = values[0];
+        lobj->rotation[1] = values[1];
+        lobj->rotation[2] = values[2];
+    }
+
+    return lobj;
+}
+
+// Vertices and indices of a mesh object, checking there are enough indices for the faces
+static void UseMesh(LevelObject* lobj, char** tokens, int tokenCount, int indicesNeeded) {
+    const NamedList* vertexList = FindList(vertexLists, vertexListCount, Value(tokens, tokenCount, "verts", true));
+    const NamedList* indexList = FindList(indexLists, indexListCount, Value(tokens, tokenCount, "indices", true));
+
+    if (indexList->count < indicesNeeded) {
+        Fail("index list '%s' has %d indices, %d are needed", indexList->name, indexList->count, indicesNeeded);
+    }
+
+    lobj->firstVertex = UseVertexList(vertexList, NULL);
+    lobj->firstIndex = UseIndexList(indexList->values, indicesNeeded, vertexList->count / 3);
+}
+
+// r,g,b/r,g,b/... one colour per face, each becoming an F4 template. Returns the first one
+static int AddPolyF4s(const char* text, int faces) {
+    int colours[MAXTOKENS];
+    char buffer[MAXLINE];
+    int colourCount = 0;
+    int firstPoly = polyF4Count;
+
+    strncpy(buffer, text, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char* colour = strtok(buffer, "/"); colour != NULL; colour = strtok(NULL, "/")) {
+        if (colourCount + 3 > MAXTOKENS) {
+            Fail("too many colours");
+        }
+
+        int rgb[3];
+        ParseExact(colour, rgb, 3);
+        memcpy(&colours[colourCount], rgb, sizeof(rgb));
+        colourCount += 3;
+    }
+
+    if (colourCount / 3 != faces) {
+        Fail("flat faces need one colour each");
+    }
+
+    for (int i = 0; i < faces; i++) {
+        if (polyF4Count == MAXPOLYS) {
+            Fail("too many flat faces");
+        }
+
+        LevelPolyF4* poly = &polyF4s[polyF4Count++];
+        memset(poly, 0, sizeof(LevelPolyF4));
+        poly->tag = POLYF4LEN << 24;
+        poly->code = POLYF4CODE;
+        poly->r0 = colours[(i * 3) + 0];
+        poly->g0 = colours[(i * 3) + 1];
+        poly->b0 = colours[(i * 3) + 2];
+    }
+
+    return firstPoly;
+}
+
+static void AddPolyF4Object(char** tokens, int tokenCount) {
+    int values[2];
+    LevelObject* lobj = AddObject(LOT_PolyF4, tokens, tokenCount);
+
+    lobj->polyLength = ParseCount(tokens, tokenCount, "faces");
+    UseMesh(lobj, tokens, tokenCount, lobj->polyLength * 4);
+
+    const char* box = Value(tokens, tokenCount, "box", false);
+    if (box != NULL) {
+        ParseExact(box, values, 2);
+        lobj->boxHeight = values[0];
+        lobj->boxWidth = values[1];
+    }
+
+    lobj->firstPoly = AddPolyF4s(Value(tokens, tokenCount, "colours", true), lobj->polyLength);
+    FitBoundsToIndices(lobj, lobj->polyLength * 4, 0);
+}
+
+// polyft4 and tiledft4. Tiled objects only use their first face, repeated along X
+static void AddTexturedObject(enum LevelObjectType type, char** tokens, int tokenCount) {
+    LevelObject* lobj = AddObject(type, tokens, tokenCount);
+    const LevelMaterial* material = FindMaterial(Value(tokens, tokenCount, "material", true));
+    bool tiled = (type == LOT_TiledFT4);
+
+    lobj->polyLength = ParseCount(tokens, tokenCount, tiled ? "tiles" : "faces");
+    UseMesh(lobj, tokens, tokenCount, tiled ? 4 : lobj->polyLength * 4);
+    lobj->firstMaterial = AddMaterial(material);
+    lobj->firstPoly = polyFT4Count;
+
+    for (int i = 0; i < lobj->polyLength; i++) {
+        AddPolyFT4(material, material->u0, material->v0, material->uvwidth, material->uvheight);
+    }
+
+    FitBoundsToIndices(lobj, tiled ? 4 : lobj->polyLength * 4, tiled ? TILEDSEGMENTLENGTH * (lobj->polyLength - 1) : 0);
+}
+
+// A panel of width/height/depth (depth 0 for walls, height 0 for floors), repeated along X
+// and split into subdivs * subdivs faces per repeat
+static void AddMultiPolyObject(char** tokens, int tokenCount) {
+    static const int forwardIndices[] = { 0, 1, 2, 3 };
+    static const int reverseIndices[] = { 0, 3, 2, 1 };
+    int size[3];
+    Vertex vertices[4];
+    LevelObject* lobj = AddObject(LOT_MultiPoly, tokens, tokenCount);
+    const LevelMaterial* material = FindMaterial(Value(tokens, tokenCount, "material", true));
+
+    lobj->polyLength = ParseCount(tokens, tokenCount, "repeats");
+    lobj->subdivs = ParseCount(tokens, tokenCount, "subdivs");
+    ParseExact(Value(tokens, tokenCount, "size", true), size, 3);
+
+    if (lobj->polyLength > 255 || lobj->subdivs > 255 || size[0] > 255 || size[1] > 255 || size[2] > 255) {
+        Fail("multipoly repeats, subdivs and size have to fit in a byte");
+    }
+
+    lobj->width = size[0];
+    lobj->height = size[1];
+    lobj->depth = size[2];
+
+    int w = lobj->width;
+    int h = lobj->height;
+    int d = lobj->depth;
+
+    if (w == 0 || (h == 0 && d == 0)) {
+        Fail("multipoly needs a width and either a height or a depth");
+    }
+
+    // Panel corners, walls are upright in XY and floors flat in XZ
+    memset(vertices, 0, sizeof(vertices));
+
+    if (h == 0) {
+        vertices[0].vz = d;
+        vertices[1].vx = w; vertices[1].vz = d;
+        vertices[2].vx = w;
+    }
+    else {
+        vertices[0].vy = -h;
+        vertices[1].vx = w; vertices[1].vy = -h;
+        vertices[2].vx = w;
+    }
+
+    // The shared lattice every face of the object is drawn from, see level.h
+    int columns = (lobj->polyLength * lobj->subdivs) + 1;
+    int rows = lobj->subdivs + 1;
+    int sw = w / lobj->subdivs;
+    int sh = h / lobj->subdivs;
+    int sd = d / lobj->subdivs;
+    Vertex lattice[MULTIPOLYMAXLATTICE];
+
+    if (columns * rows > MULTIPOLYMAXLATTICE) {
+        Fail("multipoly needs %d lattice vertices, at most %d are allowed", columns * rows, MULTIPOLYMAXLATTICE);
+    }
+
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            Vertex* v = &lattice[(row * columns) + column];
+
+            v->vx = sw * column;
+            v->vy = (h != 0) ? -sh * row : 0;
+            v->vz = (h != 0) ? 0 : sd * row;
+            v->pad = 0;
+        }
+    }
+
+    // Each panel corner becomes an offset to the next column and/or row
+    const int* order = (lobj->flags & LOF_ReverseOrder) ? reverseIndices : forwardIndices;
+    int corners[4];
+
+    for (int i = 0; i < 4; i++) {
+        const Vertex* v = &vertices[order[i]];
+        int nextRow = (h != 0) ? (v->vy != 0) : (v->vz != 0);
+
+        corners[i] = (nextRow ? columns : 0) + (v->vx != 0);
+    }
+
+    lobj->firstVertex = AddVertices(lattice, columns * rows);
+    lobj->firstIndex = UseIndexList(corners, 4, columns * rows);
+    lobj->firstMaterial = AddMaterial(material);
+    lobj->firstPoly = polyFT4Count;
+
+    // Walks the texture in subdivs steps, wrapping back to the start of the material's UV rectangle
+    u_char u0 = material->u0;
+    u_char v0 = material->v0;
+    u_char utemp = u0;
+    u_char vtemp = v0;
+    u_short uvtemp;
+    int subdivs = lobj->subdivs;
+    int repeats = lobj->polyLength;
+
+    if (subdivs > 1) {
+        u_char divuwidth = material->uvwidth / subdivs;
+        u_char divvheight = material->uvheight / subdivs;
+
+        for (int i = 0; i < subdivs; i++) {
+            for (int j = 0; j < repeats * subdivs; j++) {
+                AddPolyFT4(material, utemp, vtemp, divuwidth, divvheight);
+
+                uvtemp = utemp + divuwidth;
+                if ((uvtemp - u0) >= material->uvwidth || uvtemp > 256) {
+                    utemp = u0;
+                }
+                else if (uvtemp == 256) {
+                    utemp = 255;
+                }
+                else {
+                    utemp += divuwidth;
+                }
+            }
+
+            uvtemp = vtemp + divvheight;
+            if ((uvtemp - v0) >= material->uvheight || uvtemp > 256) {
+                vtemp = v0;
+            }
+            else if (uvtemp == 256) {
+                vtemp = 255;
+            }
+            else {
+                vtemp += divvheight;
+            }
+
+            utemp = u0;
+        }
+    }
+    else {
+        for (int i = 0; i < repeats; i++) {
+            AddPolyFT4(material, u0, v0, material->uvwidth, material->uvheight);
+        }
+    }
+
+    Vertex mins = { 0, -h, 0, 0 };
+    Vertex maxs = { w * repeats, 0, d, 0 };
+    FitBounds(lobj, mins, maxs);
+}
+
+// 8 corners in box order, one material per face. Also goes into the collision grid
+// Faces only list their material, boxes sharing materials share the templates the console builds from them
+static void AddColBoxObject(char** tokens, int tokenCount) {
+    Vertex vertices[MAXTOKENS / 3];
+    char buffer[MAXLINE];
+    int faceMaterials = 0;
+    LevelObject* lobj = AddObject(LOT_ColBox, tokens, tokenCount);
+    const NamedList* vertexList = FindList(vertexLists, vertexListCount, Value(tokens, tokenCount, "verts", true));
+
+    if (vertexList->count != 24) {
+        Fail("colbox needs exactly 8 vertices");
+    }
+
+    lobj->polyLength = 6;
+    lobj->firstVertex = UseVertexList(vertexList, vertices);
+    lobj->firstIndex = UseIndexList(cubeIndices, 24, 8);
+    lobj->firstPoly = faceCount;
+
+    strncpy(buffer, Value(tokens, tokenCount, "materials", true), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char* name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ",")) {
+        const LevelMaterial* material = FindMaterial(name);
+
+        if (faceMaterials == 6) {
+            Fail("colbox needs exactly 6 materials");
+        }
+
+        if (faceCount == MAXFACES) {
+            Fail("too many colbox faces");
+        }
+
+        int index = AddMaterial(material);
+        if (faceMaterials == 0) {
+            lobj->firstMaterial = index;
+        }
+
+        faces[faceCount++] = index;
+        faceMaterials++;
+    }
+
+    if (faceMaterials != 6) {
+        Fail("colbox needs exactly 6 materials");
+    }
+
+    FitBoundsToIndices(lobj, 24, 0);
+
+    // Same footprint BuildCollisionGrid() uses: the position is the low corner, vertex 5 the far top corner
+    ColGridBounds* bounds = &gridBoxes[gridBoxCount++];
+    bounds->minX = lobj->position[0];
+    bounds->minZ = lobj->position[2];
+    bounds->maxX = lobj->position[0] + vertices[5].vx;
+    bounds->maxZ = lobj->position[2] + vertices[5].vz;
+}
+
+// A cheaper mesh for the object on the line before, drawn from distance= on. Without verts= the object's own mesh
+// is reused, and with colours= it's drawn flat from F4 templates, which PolyF4 objects and colboxes need
+static void AddLod(char** tokens, int tokenCount) {
+    if (objectCount == 0) {
+        Fail("lod has to follow an object");
+    }
+
+    LevelObject* lobj = &objects[objectCount - 1];
+    const char* colours = Value(tokens, tokenCount, "colours", false);
+    int distance = ParseCount(tokens, tokenCount, "distance");
+
+    if (lobj->type == LOT_TiledFT4 || lobj->type == LOT_MultiPoly) {
+        Fail("only polyf4, polyft4 and colbox objects can have lods");
+    }
+
+    if ((lobj->type == LOT_PolyF4 || lobj->type == LOT_ColBox) && colours == NULL) {
+        Fail("lods of polyf4 and colbox objects need colours=");
+    }
+
+    if (lobj->lodCount > 0 && distance <= lods[lodCount - 1].distance) {
+        Fail("lods have to go from near to far");
+    }
+
+    if (lobj->lodCount == 255 || lodCount == MAXLODS) {
+        Fail("too many lods");
+    }
+
+    LevelLod* lod = &lods[lodCount++];
+    memset(lod, 0, sizeof(LevelLod));
+    lod->distance = distance;
+    lod->polyLength = lobj->polyLength;
+    lod->firstVertex = lobj->firstVertex;
+    lod->firstIndex = lobj->firstIndex;
+    lod->flat = colours != NULL;
+    lobj->lodCount++;
+
+    if (Value(tokens, tokenCount, "verts", false) != NULL) {
+        LevelObject mesh;
+
+        if (lobj->type == LOT_ColBox) {
+            Fail("colbox lods keep the box's own mesh");
+        }
+
+        lod->polyLength = ParseCount(tokens, tokenCount, "faces");
+        UseMesh(&mesh, tokens, tokenCount, lod->polyLength * 4);
+        lod->firstVertex = mesh.firstVertex;
+        lod->firstIndex = mesh.firstIndex;
+    }
+
+    if (lod->flat) {
+        lod->firstPoly = AddPolyF4s(colours, lod->polyLength);
+        return;
+    }
+
+    const LevelMaterial* material = &materialTable[lobj->firstMaterial];
+    lod->firstPoly = polyFT4Count;
+
+    for (int i = 0; i < lod->polyLength; i++) {
+        AddPolyFT4(material, material->u0, material->v0, material->uvwidth, material->uvheight);
+    }
+}
+
+// cell <name> box=x0,y0,z0,x1,y1,z1
+static void AddCell(char** tokens, int tokenCount) {
+    int values[6];
+
+    if (tokenCount < 3) {
+        Fail("cell needs a name and box=");
+    }
+    if (cellCount == MAXCELLS) {
+        Fail("too many cells");
+    }
+
+    ParseExact(Value(tokens + 1, tokenCount - 1, "box", true), values, 6);
+
+    LevelCell* cell = &cells[cellCount];
+    CopyName(cellNames[cellCount++], tokens[1]);
+
+    for (int i = 0; i < 3; i++) {
+        cell->mins[i] = (values[i] < values[i + 3]) ? values[i] : values[i + 3];
+        cell->maxs[i] = (values[i] < values[i + 3]) ? values[i + 3] : values[i];
+    }
+}
+
+// portal cells=a,b verts= pos=, the 4 vertices going around the opening. Either side can be outside
+static void AddPortal(char** tokens, int tokenCount) {
+    char buffer[MAXLINE];
+    int position[3];
+    int sides = 0;
+
+    if (portalCount == MAXPORTALS) {
+        Fail("too many portals");
+    }
+
+    const NamedList* vertexList = FindList(vertexLists, vertexListCount, Value(tokens, tokenCount, "verts", true));
+
+    if (vertexList->count != 12) {
+        Fail("portal needs exactly 4 vertices");
+    }
+
+    LevelPortal* portal = &portals[portalCount++];
+    memset(portal, 0, sizeof(LevelPortal));
+    ParseExact(Value(tokens, tokenCount, "pos", true), position, 3);
+
+    for (int i = 0; i < 4; i++) {
+        for (int k = 0; k < 3; k++) {
+            portal->corners[i][k] = vertexList->values[(i * 3) + k] + position[k];
+        }
+    }
+
+    strncpy(buffer, Value(tokens, tokenCount, "cells", true), sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char* name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (sides == 2) {
+            Fail("portal connects exactly 2 cells");
+        }
+
+        portal->cells[sides++] = FindCell(name);
+    }
+
+    if (sides != 2 || portal->cells[0] == portal->cells[1]) {
+        Fail("portal connects exactly 2 cells");
+    }
+}
+
+// ---- Output ----
+
+static size_t Align4(size_t value) {
+    return (value + 3) & ~3;
+}
+
+static void WriteSection(FILE* file, const void* data, size_t size) {
+    static const char padding[4] = { 0 };
+
+    if (size > 0 && fwrite(data, size, 1, file) != 1) {
+        fprintf(stderr, "levelc: write failed\n");
+        exit(1);
+    }
+
+    fwrite(padding, Align4(size) - size, 1, file);
+}
+
+static void WriteLevel(const char* path) {
+    LevelHeader header = { 0 };
+    ColGrid grid = { 0 };
+    ColGridImage* gridImage = NULL;
+    size_t gridSize = 0;
+
+    if (gridBoxCount > 0) {
+        if (!ColGridBuild(&grid, gridBoxes, gridBoxCount)) {
+            fprintf(stderr, "levelc: collision grid doesn't fit\n");
+            exit(1);
+        }
+
+        gridSize = ColGridImageSize(&grid);
+        gridImage = calloc(1, gridSize);
+        ColGridWriteImage(&grid, gridImage);
+        ColGridFree(&grid);
+    }
+
+    header.magic = LEVELMAGIC;
+    header.version = LEVELVERSION;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    header.materialCount = materialCount;
+    header.polyF4Count = polyF4Count;
+    header.polyFT4Count = polyFT4Count;
+    header.lodCount = lodCount;
+    header.cellCount = cellCount;
+    header.portalCount = portalCount;
+    header.faceCount = faceCount;
+
+    for (int i = 0; i < objectCount; i++) {
+        header.objectCounts[objects[i].type]++;
+    }
+
+    header.vertexOffset = sizeof(LevelHeader);
+    header.indexOffset = header.vertexOffset + Align4(vertexCount * sizeof(Vertex));
+    header.materialOffset = header.indexOffset + Align4(indexCount * sizeof(u_int));
+    header.objectOffset = header.materialOffset + Align4(materialCount * sizeof(LevelMaterial));
+    header.polyF4Offset = header.objectOffset + Align4(objectCount * sizeof(LevelObject));
+    header.polyFT4Offset = header.polyF4Offset + Align4(polyF4Count * sizeof(LevelPolyF4));
+    header.lodOffset = header.polyFT4Offset + Align4(polyFT4Count * sizeof(LevelPolyFT4));
+    header.cellOffset = header.lodOffset + Align4(lodCount * sizeof(LevelLod));
+    header.portalOffset = header.cellOffset + Align4(cellCount * sizeof(LevelCell));
+    header.faceOffset = header.portalOffset + Align4(portalCount * sizeof(LevelPortal));
+    header.gridOffset = (gridImage != NULL) ? header.faceOffset + Align4(faceCount * sizeof(u_short)) : 0;
+
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "levelc: can't write %s\n", path);
+        exit(1);
+    }
+
+    WriteSection(file, &header, sizeof(header));
+    WriteSection(file, vertexPool, vertexCount * sizeof(Vertex));
+    WriteSection(file, indexPool, indexCount * sizeof(u_int));
+    WriteSection(file, materialTable, materialCount * sizeof(LevelMaterial));
+    WriteSection(file, objects, objectCount * sizeof(LevelObject));
+    WriteSection(file, polyF4s, polyF4Count * sizeof(LevelPolyF4));
+    WriteSection(file, polyFT4s, polyFT4Count * sizeof(LevelPolyFT4));
+    WriteSection(file, lods, lodCount * sizeof(LevelLod));
+    WriteSection(file, cells, cellCount * sizeof(LevelCell));
+    WriteSection(file, portals, portalCount * sizeof(LevelPortal));
+    WriteSection(file, faces, faceCount * sizeof(u_short));
+    WriteSection(file, gridImage, gridSize);
+
+    long size = ftell(file);
+    fclose(file);
+    free(gridImage);
+
+    printf("levelc: %s, %d objects, %d lods, %d cells, %d portals, %d vertices, %d indices, %d + %d templates, %d materials, %ld bytes\n",
+        path, objectCount, lodCount, cellCount, portalCount, vertexCount, indexCount, polyF4Count, polyFT4Count, materialCount, size);
+}
+
+int main(int argc, char** argv) {
+    char line[MAXLINE];
+    char* tokens[MAXTOKENS];
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: levelc <scene.txt> <level.lvl>\n");
+        return 1;
+    }
+
+    sourcePath = argv[1];
+    FILE* file = fopen(sourcePath, "r");
+
+    if (file == NULL) {
+        fprintf(stderr, "levelc: can't open %s\n", sourcePath);
+        return 1;
+    }
+
+    while (ReadLine(file, line)) {
+        int tokenCount = Tokenise(line, tokens);
+
+        if (tokenCount == 0) {
+            continue;
+        }
+
+        const char* command = tokens[0];
+
+        if (strcmp(command, "texture") == 0) {
+            if (tokenCount != 3) {
+                Fail("texture needs a name and a TIM path");
+            }
+
+            AddTexture(tokens[1], tokens[2]);
+        }
+        else if (strcmp(command, "vertices") == 0) {
+            AddNamedList(vertexLists, &vertexListCount, tokens, tokenCount, 3);
+        }
+        else if (strcmp(command, "box") == 0) {
+            AddBoxList(tokens, tokenCount);
+        }
+        else if (strcmp(command, "indices") == 0) {
+            AddNamedList(indexLists, &indexListCount, tokens, tokenCount, 4);
+        }
+        else if (strcmp(command, "material") == 0) {
+            AddMaterialDefinition(tokens, tokenCount);
+        }
+        else if (strcmp(command, "polyf4") == 0) {
+            AddPolyF4Object(tokens, tokenCount);
+        }
+        else if (strcmp(command, "polyft4") == 0) {
+            AddTexturedObject(LOT_PolyFT4, tokens, tokenCount);
+        }
+        else if (strcmp(command, "tiledft4") == 0) {
+            AddTexturedObject(LOT_TiledFT4, tokens, tokenCount);
+        }
+        else if (strcmp(command, "multipoly") == 0) {
+            AddMultiPolyObject(tokens, tokenCount);
+        }
+        else if (strcmp(command, "colbox") == 0) {
+            AddColBoxObject(tokens, tokenCount);
+        }
+        else if (strcmp(command, "lod") == 0) {
+            AddLod(tokens, tokenCount);
+        }
+        else if (strcmp(command, "cell") == 0) {
+            AddCell(tokens, tokenCount);
+        }
+        else if (strcmp(command, "portal") == 0) {
+            AddPortal(tokens, tokenCount);
+        }
+        else {
+            Fail("unknown command '%s'", command);
+        }
+    }
+
+    fclose(file);
+    WriteLevel(argv[2]);
+
+    return 0;
+}